@@ -23,9 +23,9 @@ int main()
     MakeAccessible(open_path, output_dir + L"/MakeAccessible.pdf", 
       std::make_pair(false, L""), std::make_pair(true, L"Document title"), 
       config_path,
-      false);
+      false, nullptr);
 
-    AddTags(open_path, output_dir + L"/AddTags.pdf", config_path, true);
+    AddTags(open_path, output_dir + L"/AddTags.pdf", config_path, true, nullptr);
 
     // TagsReadStructTree(open_path, output_dir + L"/TagsReadStructTree.txt", config_path);
     // TagTableAsFigure::Run(open_path, output_dir + L"/TagTableAsFigure.pdf");
@@ -41,18 +41,42 @@ int main()
     extract_data.page_map = true;       // extract page map data for data scraping
     extract_data.extract_text = true;   // extract text
     ExtractData::Run(open_path, config_path, std::cout, extract_data, true, kDataFormatJson);
+    {
+      // compressed on its own thread while the data are extracted
+      OutputSink extract_data_output(output_dir + L"/ExtractData.json.gz", kOutputGzip);
+      ExtractData::Run(open_path, config_path, extract_data_output, extract_data, true,
+        kDataFormatJson);
+      extract_data_output.Close();
+    }
 
     PdfImageParams image_params;
     ExtractImages(open_path, output_dir + L"/", 800, image_params);
-    ExtractTables(open_path, output_dir + L"/");
+    ExtractTables(open_path, output_dir + L"/", kOutputGzip);
+    TextColumns::Run(open_path, output_dir + L"/TextColumns.bin", config_path, 65536);
+    TextIndex::Run(open_path, L"pdf document");
     ExtractHighlightedText(open_path, output_dir + L"/ExtractHighlightedText.txt", config_path);
+    {
+      // the character index maps text offsets on each page to character boxes
+      OutputSink extract_text_output(output_dir + L"/ExtractText.txt", kOutputPlain);
+      ExtractText::Run(open_path, extract_text_output, config_path, -1,
+        output_dir + L"/ExtractText.charindex");
+      extract_text_output.Close();
+    }
 
     // PDF to HTML samples
     PdfHtmlParams html_params;
     html_params.flags |= (kHtmlNoExternalCSS | kHtmlNoExternalIMG | kHtmlNoExternalJS);
-    ConvertToHtml(open_path, output_dir + L"/fixed.html", config_path, html_params, true);
+    HtmlAssetCache html_assets(output_dir + L"/assets", "assets/");
+    ConvertToHtml(open_path, output_dir + L"/fixed.html", config_path, html_params, true,
+      &html_assets);
     html_params.type = kPdfHtmlResponsive;
-    ConvertToHtml(open_path, output_dir + L"/responsive.html", config_path, html_params, true);
+    ConvertToHtml(open_path, output_dir + L"/responsive.html", config_path, html_params, true,
+      &html_assets);
+    ConvertToHtmlParallel(open_path, output_dir + L"/responsive_parallel.html", config_path, html_params, true, 4, &html_assets, nullptr);
+    ConvertToHtmlIncremental(open_path, output_dir + L"/responsive_incremental.html", config_path, html_params, true, &html_assets, nullptr);
+    // serve the resources folder for a second
+    CancelToken server_stop(nullptr, 1000);
+    HtmlPageServer::Run(resources_dir, 8080, html_params, 4, 64 << 20, 3, &html_assets, &server_stop);
 
     PdfHtmlParams html_params_ex;
     html_params_ex.flags |= (kHtmlNoExternalCSS | kHtmlNoExternalIMG | kHtmlNoExternalJS);
@@ -76,6 +100,18 @@ int main()
     // Render & Print
     PdfDevRect clip_area;
     RenderPage(open_path, output_dir + L"/RenderPage.jpg", image_params, 1, 1.0, kRotate0, clip_area);
+    RenderPagesPipelined(open_path, output_dir + L"/RenderPagesPipelined_", image_params, 0, 0, 1.0,
+      kRotate0, clip_area, 2, 2, 4, nullptr, 30000);
+    std::vector<RenderPageVariant> variants = {
+      { 2.0, L"_full" }, { 1.0, L"_preview" }, { 0.25, L"_thumb" } };
+    RenderPagesMultiResolution(open_path, output_dir + L"/RenderPagesMultiResolution_", 0, 0,
+      kRotate0, variants, kResampleLanczos, 2, nullptr, 30000);
+    Thumbnails::ThumbnailParams thumbnail_params;
+    Thumbnails::Run(open_path, output_dir + L"/thumbnails", 64 * 1024 * 1024, thumbnail_params, 4);
+    RenderPageGray(open_path, output_dir + L"/RenderPageGray.png", 0, 2.0, kRotate0, PdfDevRect(),
+      kImageBufferBitonal);
+    RenderPageLayers::Run(open_path, output_dir + L"/RenderPageLayers_", 0, { 1.0, 2.0 }, kRotate0);
+    RenderPageTiles::Run(open_path, output_dir + L"/RenderPageTiles.dzi", 0, 4.0, kRotate0, 256);
 
     // Signing and form-filling
     DigitalSignature(open_path, output_dir + L"/DigitalSignature.pdf", resources_dir + L"/test.pfx", L"TEST_PASSWORD");
@@ -86,8 +122,12 @@ int main()
     SetFieldFlags(open_path, output_dir + L"/SetFieldFlags.pdf");
 
     // OCR Tesseract
-    OcrWithTesseract(open_path, output_dir + L"/OcrTesseract.pdf", resources_dir + L"/tessdata", L"eng", 2., kRotate0);
-    OcrPageImagesWithTesseract(open_path, output_dir + L"/OcrPageImagesWithTesseract.pdf", resources_dir + L"/tessdata", L"eng", 2., kRotate0);
+    OcrWithTesseract(open_path, output_dir + L"/OcrTesseract.pdf", resources_dir + L"/tessdata", L"eng", 300. / 72, kRotate0, kImageBufferGray, nullptr, 60000, output_dir + L"/ocr_cache");
+    OcrWithTesseractParallel(open_path, output_dir + L"/OcrTesseractParallel.pdf", resources_dir + L"/tessdata", L"eng", 2., kRotate0, kImageBufferGray, 4, nullptr, 60000);
+    OcrPageImagesWithTesseract(open_path, output_dir + L"/OcrPageImagesWithTesseract.pdf", resources_dir + L"/tessdata", L"eng", 300. / 72, kRotate0, kImageBufferGray, nullptr, output_dir + L"/ocr_cache");
+    OcrTriage::Run(open_path, output_dir + L"/OcrTriage.pdf", resources_dir + L"/tessdata", L"eng", 2., kRotate0, kImageBufferGray, nullptr);
+    OcrPreprocess::Params preprocess_params;
+    OcrPreprocess::Run(open_path, output_dir + L"/OcrPreprocess.pdf", resources_dir + L"/tessdata", L"eng", 2., kRotate0, preprocess_params, nullptr);
 
     // Miscelaneous
     BookmarksToJson::Run(open_path, std::cout);
@@ -1,10 +1,12 @@
 #pragma once
 
 #include <string>
+#include "CancelToken.h"
 
 void AddTags(
     const std::wstring& open_path,        // source PDF document
     const std::wstring& save_path,        // output PDF document
     const std::wstring& config_path,      // configuration file
-    const bool preflight                  // preflight document template before processing
+    const bool preflight,                 // preflight document template before processing
+    CancelToken* cancel                   // cancel token or nullptr
     );
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <stdexcept>
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+// Thrown when an SDK call was interrupted by a CancelToken.
+class CancelException : public std::runtime_error {
+public:
+  explicit CancelException(bool expired)
+    : std::runtime_error(expired ? "Time budget exceeded" : "Operation cancelled"),
+      expired_(expired) {}
+  // true when the deadline passed, false when the token was cancelled
+  bool IsExpired() const { return expired_; }
+
+private:
+  bool expired_;
+};
+
+// CancelToken is passed as cancel_data together with CancelToken::CancelProc to the SDK calls that
+// accept PdfCancelProc. It can be cancelled from any thread and can have a deadline. A token with a
+// parent stops with its parent too, e.g. a per-page budget inside a whole document job.
+class CancelToken {
+public:
+  CancelToken(
+      const CancelToken* parent = nullptr,  // parent token or nullptr
+      int timeout = 0                       // time budget in milliseconds, 0 for no deadline
+      );
+  CancelToken(const CancelToken&) = delete;
+  CancelToken& operator=(const CancelToken&) = delete;
+
+  void Cancel();
+  // Sets the deadline timeout milliseconds from now, 0 removes the deadline.
+  void SetTimeout(int timeout);
+
+  bool IsCancelled() const;
+  bool IsExpired() const;
+  bool IsStopped() const { return IsCancelled() || IsExpired(); }
+
+  // PdfCancelProc implementation, data is a CancelToken* or nullptr.
+  static int CancelProc(void* data);
+
+  // Throws CancelException when the token is not nullptr and stopped. Called after an SDK call
+  // failed to tell cancellation from other errors.
+  static void ThrowIfStopped(const CancelToken* token);
+
+private:
+  const CancelToken* parent_;
+  std::atomic<bool> cancelled_;
+  std::atomic<long long> deadline_;         // steady clock ticks, 0 for no deadline
+};
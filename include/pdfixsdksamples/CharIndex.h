@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include "MappedFile.h"
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+// Character geometry index for highlighting of search hits without the PDF. Each page keeps its
+// text built from the page map words, one record per word and one quad per text offset. Offsets
+// are in UTF-16 code units, as used by JavaScript strings, a ligature is split evenly among its
+// characters. Quads are the character boxes quantised to 16 bits over the page crop box.
+//
+// File layout, numbers in the byte order of the writer (little-endian on x86 and ARM):
+//   char     magic[8]                "PDFIXCI1"
+//   pages, each of them aligned to 8 bytes:
+//     float32  left, bottom, width, height   quantisation box, the page crop box
+//     uint32   num_words, num_quads, text_size, reserved
+//     words[num_words]: uint32 text_offset, uint32 first_quad, uint16 num_units, uint16 reserved
+//     quads[num_quads]: uint16 left, bottom, right, top, value = box.left + q * box.width / 65535
+//     char     text[text_size]       UTF-8 page text, words separated by spaces and line breaks
+//   pages[num_pages]: uint64 offset, uint32 page_num, uint32 reserved
+//   trailer: uint64 num_pages, pages_offset; char magic[8] "PDFIXCI1"
+namespace CharIndex {
+  // Writer builds the index page by page.
+  class Writer {
+  public:
+    explicit Writer(const std::wstring& save_path);
+
+    // Adds the words of the page map to the index, returns the UTF-8 page text.
+    std::string AddPage(PdfPage* page, PdeElement* element);
+
+    // Writes the page table and the trailer.
+    void Close();
+
+  private:
+    void Write(const void* data, size_t size);
+
+    std::ofstream file_;
+    uint64_t offset_ = 0;
+    std::vector<std::pair<uint64_t, int>> pages_;   // page section offset and page number
+  };
+
+  // Reader maps the index and looks up the quads in place.
+  class Reader {
+  public:
+    explicit Reader(const std::wstring& path);
+
+    int GetNumPages() const { return (int)pages_.size(); }
+    bool HasPage(int page_num) const;
+    std::string GetPageText(int page_num) const;
+
+    // Returns the boxes of the text range on the page, characters of one word are merged into
+    // one box.
+    std::vector<PdfRect> GetQuads(int page_num, uint32_t offset, uint32_t length) const;
+
+  private:
+    struct Page;
+    Page GetPage(int page_num) const;
+
+    MappedFile file_;
+    std::vector<std::pair<uint64_t, int>> pages_;
+  };
+}
@@ -3,13 +3,19 @@
 #include <string>
 #include "Pdfix.h"
 #include "PdfToHtml.h"
+#include "HtmlAssetCache.h"
+#include "CancelToken.h"
 
 using namespace PDFixSDK;
 
+// Converts the document to HTML. With assets, the static CSS and JavaScript embedded by the
+// kHtmlNoExternalCSS and kHtmlNoExternalJS flags are replaced with references to the shared files.
 void ConvertToHtml(
     const std::wstring& open_path,      // source PDF document
     const std::wstring& save_path,      // output HTML file
     const std::wstring& config_path,    // configuration file
     PdfHtmlParams& html_params,         // conversion parameters
-    const bool preflight                // preflight document template before processing
+    const bool preflight,               // preflight document template before processing
+    HtmlAssetCache* assets = nullptr,   // shared CSS and JavaScript or nullptr to embed them
+    CancelToken* cancel = nullptr       // cancel token or nullptr
     );
@@ -3,6 +3,7 @@
 #include <string>
 #include "Pdfix.h"
 #include "PdfToHtml.h"
+#include "CancelToken.h"
 
 using namespace PDFixSDK;
 
@@ -12,5 +13,6 @@ void ConvertToHtmlEx(
     const std::wstring& config_path,    // configuration
     PdfHtmlParams& html_params,         // conversion parameters
     const std::wstring& param1,         // param 1
-    const std::wstring& param2          // param 2
+    const std::wstring& param2,         // param 2
+    CancelToken* cancel = nullptr       // cancel token or nullptr
     );
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <unordered_map>
+#include "Pdfix.h"
+#include "PdfToHtml.h"
+#include "CancelToken.h"
+#include "HtmlAssetCache.h"
+
+using namespace PDFixSDK;
+
+// Returns the fingerprint of the page dictionary with its content streams, resources and
+// annotations, including the attributes inherited from the page tree. Objects referenced more than
+// once are hashed once, other pages are hashed by their object number only. Hashes of the stream
+// data are kept in stream_hashes by object number, so resources shared by pages are read once.
+uint64_t GetPageFingerprint(
+    PdfPage* page,                      // page to fingerprint
+    std::unordered_map<int, uint64_t>& stream_hashes  // stream data hashes by object number
+    );
+
+// Converts the document to a single HTML file like ConvertToHtmlParallel and stores the page
+// fingerprints and fragment positions in <save_path>.pages. When the file from the previous
+// conversion with the same parameters is found, only the pages with a changed fingerprint are
+// converted again, the fragments of the other pages are copied from the previous HTML file.
+void ConvertToHtmlIncremental(
+    const std::wstring& open_path,      // source PDF document
+    const std::wstring& save_path,      // output HTML file
+    const std::wstring& config_path,    // configuration file
+    PdfHtmlParams& html_params,         // conversion parameters
+    const bool preflight,               // preflight document template before processing
+    HtmlAssetCache* assets,             // shared CSS and JavaScript or nullptr to embed them
+    CancelToken* cancel                 // cancel token or nullptr
+    );
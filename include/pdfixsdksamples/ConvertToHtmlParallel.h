@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include "Pdfix.h"
+#include "PdfToHtml.h"
+#include "CancelToken.h"
+#include "HtmlAssetCache.h"
+
+using namespace PDFixSDK;
+
+// Returns the document HTML without pages, written by SaveDocHtml.
+std::string SaveHtmlShell(
+    PdfHtmlDoc* html_doc,               // HTML document
+    PdfHtmlParams& html_params,         // conversion parameters
+    CancelToken* cancel                 // cancel token or nullptr
+    );
+
+// Returns the HTML fragment of the page, written by SavePageHtml.
+std::string SaveHtmlPage(
+    PdfHtmlDoc* html_doc,               // HTML document
+    PdfHtmlParams& html_params,         // conversion parameters
+    int page_num,                       // page number
+    CancelToken* cancel                 // cancel token or nullptr
+    );
+
+// Returns the position in the document HTML where the page fragments go, before the closing body
+// tag or at the end when there is none.
+size_t GetHtmlPagesPos(const std::string& shell);
+
+// Converts the document to a single HTML file like ConvertToHtml. Page fragments are converted
+// concurrently, each worker with its own PdfHtmlDoc, and written into the document HTML in page
+// order as soon as all previous pages are written. Workers run at most a few pages ahead of the
+// writer, so memory does not grow with the document. The resources are always embedded, the
+// kHtmlNoExternal* flags are set, except for the static CSS and JavaScript which are referenced
+// from the shared files of assets when it is not nullptr.
+void ConvertToHtmlParallel(
+    const std::wstring& open_path,      // source PDF document
+    const std::wstring& save_path,      // output HTML file, gzip compressed when it ends with .gz
+    const std::wstring& config_path,    // configuration file
+    PdfHtmlParams& html_params,         // conversion parameters
+    const bool preflight,               // preflight document template before processing
+    const size_t thread_count,          // number of conversion workers
+    HtmlAssetCache* assets,             // shared CSS and JavaScript or nullptr to embed them
+    CancelToken* cancel                 // cancel token or nullptr
+    );
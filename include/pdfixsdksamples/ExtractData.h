@@ -4,8 +4,11 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <unordered_set>
+#include <unordered_map>
 #include <boost/property_tree/ptree.hpp>
 #include "Pdfix.h"
+#include "CancelToken.h"
 
 using namespace PDFixSDK;
 using namespace boost::property_tree;
@@ -45,43 +48,74 @@ namespace ExtractData {
     PdfRotate render_rotate = kRotate0;   // page rasterizing rotation of image extraction
     PdfImageFormat image_format = kImageFormatJpg;  // format of the image
 
+    // paths
+    double path_precision = 0.01;         // quantisation step of the path coordinates
+    double path_tolerance = 0;            // max deviation of simplified polylines, 0 keeps all points
+    bool path_cull = true;                // skip paths outside of the page crop box
+
     // text
-    bool text_state = false;              // extract text state information for each text object or element
+    bool text_state = false;              // extract text state of text objects and elements as style ids
+  };
+
+  // state of one document extraction shared by all its pages
+  struct DocState {
+    // Form XObjects already extracted with the matrix of their first use, later uses are written
+    // as a reference with the matrix from the first use to them
+    std::unordered_map<int, PdfMatrix> forms;
+    // text styles, written once per document and referred to by the index as the style id
+    ptree styles;
+    std::unordered_map<std::string, int> style_ids;
+    // cancel token of the extraction or nullptr
+    CancelToken* cancel = nullptr;
   };
 
   // annotations
   void ExtractAnnot(PdfAnnot *annot, ptree &node, const DataType& data_types);
 
   // page content
-  void ExtractTextObject(PdsText *text, ptree &node, const DataType &data_types);
-  void ExtractFormObject(PdsForm *form, ptree &node, const DataType &data_types);
+  void ExtractTextObject(PdsText *text, ptree &node, const DataType &data_types,
+    DocState &state);
+  void ExtractFormObject(PdsForm *form, ptree &node, const DataType &data_types,
+    DocState &state);
   void ExtractPathObject(PdsPath *path, ptree &node, const DataType &data_types);
   void ExtractImageObject(PdsImage *image, ptree &node, const DataType &data_types);
-  void ExtractPageObject(PdsPageObject *page_object, ptree &node, const DataType &data_types);
-  void ExtractPageContent(PdsContent *content, ptree &node, const DataType &data_types);
+  void ExtractPageObject(PdsPageObject *page_object, ptree &node, const DataType &data_types,
+    DocState &state);
+  void ExtractPageContent(PdsContent *content, ptree &node, const DataType &data_types,
+    DocState &state);
 
   // page map - data scraping
-  void ExtractTextElement(PdeText *text, ptree &node, const DataType& data_types);
-  void ExtractTableElement(PdeTable *table, ptree &node, const DataType &data_types);
+  void ExtractTextElement(PdeText *text, ptree &node, const DataType& data_types,
+    DocState &state);
+  void ExtractTableElement(PdeTable *table, ptree &node, const DataType &data_types,
+    DocState &state);
   void ExtractImageElement(PdeImage *image, ptree &node, const DataType &data_types);
-  void ExtractPageElement(PdeElement *element, ptree &node, const DataType &data_types);
-  void ExtractPageMap(PdePageMap *page_map, ptree &node, const DataType &data_types);
+  void ExtractPageElement(PdeElement *element, ptree &node, const DataType &data_types,
+    DocState &state);
+  void ExtractPageMap(PdePageMap *page_map, ptree &node, const DataType &data_types,
+    DocState &state);
 
   // page 
   void ExtractPageAnnots(PdfPage *page, ptree &node, const DataType& data_types);
-  void ExtractPageData(PdfPage *page, ptree &node, const DataType &data_types);
-  void ExtractPageMapData(PdfPage *page, ptree &node, const DataType &data_types);
-  void ExtractPageContentData(PdfPage *page, ptree &node, const DataType &data_types);
+  void ExtractPageData(PdfPage *page, ptree &node, const DataType &data_types,
+    DocState &state);
+  void ExtractPageMapData(PdfPage *page, ptree &node, const DataType &data_types,
+    DocState &state);
+  void ExtractPageContentData(PdfPage *page, ptree &node, const DataType &data_types,
+    DocState &state);
 
   // document
-  void ExtractDocumentPages(PdfDoc *doc, ptree &node, const DataType &data_types);
+  void ExtractDocumentPages(PdfDoc *doc, ptree &node, const DataType &data_types,
+    CancelToken* cancel = nullptr);
   void ExtractDocumentInfo(PdfDoc *doc, ptree &node, const DataType &data_types);
   void ExtractDocumentData(PdfPage *page, ptree &node, const DataType &data_types);
 
   // utils
   std::string EncodeText(const std::wstring &text);
   void ExtractBBox(PdfRect bbox, ptree &node, const DataType& data_types);
+  void ExtractMatrix(PdfMatrix matrix, ptree &node, const DataType& data_types);
   void ExtractTextState(PdfTextState *text_state, ptree &node, const DataType &data_types);
+  int InternTextState(PdfTextState *text_state, const DataType &data_types, DocState &state);
   void RenderPageArea(PdfPage *page, PdfRect &bbox, ptree &node, const DataType &data_types);
 
   void Run(
@@ -90,6 +124,7 @@ namespace ExtractData {
       std::ostream &output,             // output stream
       const DataType& data_types,       // structure containing data types to extract
       bool preflight,                   // make preflight before processing
-      PsDataFormat format               // output format
+      PsDataFormat format,              // output format
+      CancelToken* cancel = nullptr     // cancel token or nullptr
       );       
 };
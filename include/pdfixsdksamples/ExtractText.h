@@ -4,15 +4,18 @@
 #include <iostream>
 
 #include "Pdfix.h"
+#include "CancelToken.h"
 
 using namespace PDFixSDK;
 
 namespace ExtractText {
-  void GetPageText(PdfPage* page, std::stringstream &ss);
+  void GetPageText(PdfPage* page, std::stringstream &ss, CancelToken* cancel = nullptr);
   void Run(
       const std::wstring& open_path,      // source PDF document
       std::ostream& output,                // output stream
       const std::wstring& config_path,     // configuration file
-      const int page_number
+      const int page_number,
+      const std::wstring& index_path = L"", // character geometry index or empty
+      CancelToken* cancel = nullptr        // cancel token or nullptr
       );
 }
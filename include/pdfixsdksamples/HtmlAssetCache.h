@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+#include <mutex>
+#include <filesystem>
+#include "Pdfix.h"
+#include "PdfToHtml.h"
+
+using namespace PDFixSDK;
+
+// static CSS and JavaScript of the HTML conversion
+struct HtmlAssets {
+  std::string css;                      // SaveCSS content
+  std::string js;                       // SaveJavaScript content
+  std::string css_name;                 // file name with the content hash
+  std::string js_name;                  // file name with the content hash
+};
+
+// HtmlAssetCache keeps the static CSS and JavaScript of the HTML conversion in a directory under
+// content-hashed file names, so converted documents can share them and a file name never changes
+// its content. The assets depend on the PdfToHtml version only, they are generated once per version
+// and a manifest remembers the file names for later runs. It is safe to use from multiple threads.
+class HtmlAssetCache {
+public:
+  HtmlAssetCache(
+      const std::wstring& assets_dir,   // directory holding the assets
+      const std::string& assets_url     // URL of the directory used in the HTML, e.g. "assets/"
+      );
+
+  // Returns the assets of the PdfToHtml version, generates and stores them when missing.
+  const HtmlAssets& Get(PdfToHtml* pdf_to_html);
+
+  // Replaces the CSS and JavaScript embedded in the document HTML with references to the shared
+  // files. Returns false when the HTML does not embed them, it's left unchanged then.
+  bool Externalize(PdfToHtml* pdf_to_html, std::string& html);
+
+  const std::filesystem::path& GetDir() const { return dir_; }
+
+private:
+  bool Load(const std::string& manifest);
+  void Store(const std::string& name, const std::string& data);
+
+  std::filesystem::path dir_;
+  std::string url_;
+  std::string version_;                 // version of the loaded assets
+  HtmlAssets assets_;
+  std::mutex mutex_;
+};
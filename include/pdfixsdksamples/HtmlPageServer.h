@@ -0,0 +1,98 @@
+#pragma once
+
+#include <string>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <cstdint>
+#include <filesystem>
+#include <unordered_map>
+#include "Pdfix.h"
+#include "PdfToHtml.h"
+#include "BoundedQueue.h"
+#include "CancelToken.h"
+#include "HtmlAssetCache.h"
+
+using namespace PDFixSDK;
+
+namespace HtmlPageServer {
+  // PageCache converts pages of documents in a directory on demand. Open documents and converted
+  // page fragments are kept in LRU lists with limits, and pages following a requested page are
+  // converted in the background. It is safe to use from multiple threads, conversions are
+  // serialized.
+  class PageCache {
+  public:
+    PageCache(
+        PdfToHtml* pdf_to_html,         // initialized PdfToHtml
+        const std::wstring& docs_dir,   // directory with the PDF documents
+        const PdfHtmlParams& html_params, // conversion parameters
+        size_t max_docs,                // max number of open documents
+        uint64_t max_bytes,             // max total size of cached fragments
+        int prefetch_pages,             // pages converted ahead of the requested one
+        HtmlAssetCache* assets          // shared CSS and JavaScript or nullptr to embed them
+        );
+    ~PageCache();
+
+    // Returns the document HTML with a placeholder for each page, pages are loaded when they
+    // scroll into view. Returns false when there is no such document.
+    bool GetDocHtml(const std::string& name, std::string& html);
+
+    // Returns the HTML fragment of the page and queues the next pages for conversion. Returns
+    // false when there is no such document or page.
+    bool GetPageHtml(const std::string& name, int page_num, std::string& html);
+
+    uint64_t GetHits() const { return hits_; }
+    uint64_t GetMisses() const { return misses_; }
+
+  private:
+    struct Doc {
+      std::string name;
+      PdfDoc* doc = nullptr;
+      PdfHtmlDoc* html_doc = nullptr;
+      std::string html;                 // document HTML with page placeholders
+    };
+    struct Fragment {
+      std::string key;
+      std::string html;
+    };
+
+    Doc* AcquireDoc(const std::string& name);
+    bool ConvertPage(const std::string& name, int page_num, std::string* html);
+    void Prefetch();
+    void CloseDoc(Doc& doc);
+
+    PdfToHtml* pdf_to_html_;
+    std::filesystem::path dir_;
+    PdfHtmlParams html_params_;
+    size_t max_docs_;
+    uint64_t max_bytes_;
+    int prefetch_pages_;
+    HtmlAssetCache* assets_;
+    std::list<Doc> docs_;               // most recently used first
+    std::list<Fragment> fragments_;     // most recently used first
+    std::unordered_map<std::string, std::list<Fragment>::iterator> index_;
+    uint64_t total_bytes_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    std::mutex mutex_;
+    BoundedQueue<std::pair<std::string, int>> prefetch_queue_;
+    std::thread prefetcher_;
+  };
+
+  // Serves documents of docs_dir over HTTP on the loopback interface until the cancel token stops:
+  //   /<name>.pdf               document HTML, pages are loaded as they scroll into view
+  //   /<name>.pdf/page/<n>      HTML fragment of page n, starting with 1
+  //   /assets/<file>            shared CSS and JavaScript when assets is not nullptr, its URL is
+  //                             expected to be "/assets/" or "assets/"
+  // Requests are served one at a time, a connection idle for 5 seconds is closed.
+  void Run(
+      const std::wstring& docs_dir,     // directory with the PDF documents
+      int port,                         // loopback port to listen on
+      PdfHtmlParams& html_params,       // conversion parameters
+      size_t max_docs,                  // max number of open documents
+      uint64_t max_cache_bytes,         // max total size of cached fragments
+      int prefetch_pages,               // pages converted ahead of the requested one
+      HtmlAssetCache* assets,           // shared CSS and JavaScript or nullptr to embed them
+      CancelToken* cancel               // stops the server
+      );
+}
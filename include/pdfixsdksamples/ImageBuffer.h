@@ -0,0 +1,99 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+// pixel layout of the ImageBuffer
+enum ImageBufferFormat {
+  kImageBufferBgra = 0,         // 4 bytes per pixel, kImageDIBFormatArgb memory layout (B, G, R, A)
+  kImageBufferGray = 1,         // 1 byte per pixel
+  kImageBufferBitonal = 2,      // 1 bit per pixel, most significant bit first, 1 is white
+};
+
+// filter used by ResizeImageBuffer
+enum ImageResampleFilter {
+  kResampleBox = 0,             // area average, fast and sharp enough for thumbnails
+  kResampleLanczos = 1,         // Lanczos-3, best for large reduction ratios of text
+};
+
+// ImageBuffer holds raw pixels of a rendered image for processing outside of PsImage.
+struct ImageBuffer {
+  int width = 0;
+  int height = 0;
+  int stride = 0;               // bytes per row
+  ImageBufferFormat format = kImageBufferBgra;
+  std::vector<uint8_t> data;
+
+  void Create(int width, int height, ImageBufferFormat format);
+  uint8_t* Row(int y) { return data.data() + (size_t)y * stride; }
+  const uint8_t* Row(int y) const { return data.data() + (size_t)y * stride; }
+};
+
+// Copies pixels of a width x height kImageDIBFormatArgb image into a kImageBufferBgra buffer.
+void ReadImagePixels(PsImage* image, int width, int height, ImageBuffer& buffer);
+
+// Writes the buffer into the pixels of a kImageDIBFormatArgb image of the same size in place. Gray
+// and bitonal pixels are expanded to opaque gray BGRA.
+void WriteImagePixels(const ImageBuffer& buffer, PsImage* image);
+
+// Copies src into dst with its top-left corner at x, y. Both buffers must have the same format.
+void BlitImageBuffer(const ImageBuffer& src, ImageBuffer& dst, int x, int y);
+
+// Halves the buffer size with a 2x2 box filter, odd edges are averaged with themselves.
+void DownscaleHalf(const ImageBuffer& src, ImageBuffer& dst);
+
+// Resamples the buffer to width x height with a separable filter. The vertical pass is vectorised
+// with SSE2 or NEON when available. Bitonal buffers are not supported.
+void ResizeImageBuffer(const ImageBuffer& src, ImageBuffer& dst, int width, int height,
+  ImageResampleFilter filter);
+
+// Converts a kImageBufferBgra buffer to kImageBufferGray using BT.601 luma weights. The conversion
+// is vectorised with SSE2 or NEON when available.
+void ConvertToGray(const ImageBuffer& src, ImageBuffer& dst);
+
+// Converts a kImageBufferGray buffer to kImageBufferBitonal. A pixel becomes black when it is darker
+// than bias percent below the mean of its window x window neighbourhood (Bradley-Roth).
+void ThresholdAdaptive(const ImageBuffer& src, ImageBuffer& dst, int window, int bias);
+
+// Returns the Otsu threshold of a kImageBufferGray buffer, the level which best separates the
+// histogram into two classes.
+int OtsuThreshold(const ImageBuffer& src);
+
+// Converts a kImageBufferGray buffer to kImageBufferBitonal, pixels of at least threshold become
+// white. The comparison and bit packing are vectorised with SSE2 or NEON when available.
+void ThresholdGlobal(const ImageBuffer& src, ImageBuffer& dst, int threshold);
+
+// Converts a kImageBufferGray buffer to kImageBufferBitonal with the Sauvola threshold
+// mean * (1 + k * (deviation / 128 - 1)) of the window x window neighbourhood. The window sums are
+// updated with SSE2 or NEON when available.
+void ThresholdSauvola(const ImageBuffer& src, ImageBuffer& dst, int window, double k);
+
+// Estimates the skew of text lines of a kImageBufferBitonal buffer in degrees from projection
+// profiles, positive when lines descend to the right. Angles up to max_angle are tested.
+double EstimateSkew(const ImageBuffer& src, double max_angle, double precision);
+
+// Rotates a kImageBufferGray or kImageBufferBitonal buffer around its center so that lines skewed
+// by angle degrees become horizontal. The size is kept, uncovered pixels are white.
+void RotateImageBuffer(const ImageBuffer& src, ImageBuffer& dst, double angle);
+
+// Removes black pixels without black neighbours from a kImageBufferBitonal buffer. Rows are
+// processed 128 pixels at a time with SSE2 or NEON when available.
+void Despeckle(ImageBuffer& buffer);
+
+// Whitens dark bands along the edges of a kImageBufferBitonal buffer, rows and columns within
+// max_border pixels of an edge which are at least half black.
+void RemoveBorderNoise(ImageBuffer& buffer, int max_border);
+
+// Encodes the buffer into PNG. Deflate compression is used when the samples are built with zlib,
+// otherwise the image data is stored uncompressed.
+void EncodePng(const ImageBuffer& buffer, std::vector<uint8_t>& png);
+
+// Writes data into a file.
+void SaveBytes(const std::vector<uint8_t>& data, const std::wstring& path);
+
+// Encodes the buffer into PNG and saves it to path.
+void SaveImageBuffer(const ImageBuffer& buffer, const std::wstring& path);
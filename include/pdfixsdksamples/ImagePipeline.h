@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <exception>
+#include "Pdfix.h"
+#include "BoundedQueue.h"
+
+using namespace PDFixSDK;
+
+// ImagePipeline encodes rendered images on an encoder pool and writes the encoded files on a
+// separate writer thread. Rendering, compression and disk I/O overlap, and the bounded queues
+// between the stages block the render workers when encoding or writing falls behind.
+class ImagePipeline {
+public:
+  ImagePipeline(
+      const PdfImageParams& img_params,           // output image params
+      size_t encode_threads,                      // number of encoder threads
+      size_t queue_size                           // max number of images waiting in each stage
+      );
+  ~ImagePipeline();
+
+  // Takes ownership of the image and saves it (or its dev_rect area when not null) to path.
+  // Blocks while the encoder queue is full.
+  void Push(PsImage* image, const PdfDevRect* dev_rect, const std::wstring& path);
+
+  // Waits until all pushed images are written and rethrows the first error of any stage.
+  void Finish();
+
+  // Returns true after an encode or write error, further images would be dropped so the render
+  // workers stop rendering them.
+  bool HasError();
+
+private:
+  struct EncodeJob {
+    PsImage* image = nullptr;
+    bool has_rect = false;
+    PdfDevRect rect;
+    std::wstring path;
+  };
+  struct WriteJob {
+    std::wstring path;
+    std::vector<unsigned char> data;
+  };
+
+  void Encode();
+  void Write();
+  void SetError(std::exception_ptr error);
+
+  PdfImageParams img_params_;
+  BoundedQueue<EncodeJob> encode_queue_;
+  BoundedQueue<WriteJob> write_queue_;
+  std::vector<std::thread> encoders_;
+  std::thread writer_;
+  std::mutex error_mutex_;
+  std::exception_ptr error_;
+  bool finished_ = false;
+};
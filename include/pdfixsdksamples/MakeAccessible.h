@@ -2,6 +2,7 @@
 
 #include <string>
 #include <optional>
+#include "CancelToken.h"
 
 void MakeAccessible(
     const std::wstring& open_path,           // source PDF document
@@ -9,5 +10,6 @@ void MakeAccessible(
     std::pair<bool, std::wstring> language,  // document reading language
     std::pair<bool, std::wstring> title,     // document title
     const std::wstring& config_path,         // configuration file
-    const bool preflight                     // preflight document template before processing
+    const bool preflight,                    // preflight document template before processing
+    CancelToken* cancel                      // cancel token or nullptr
     );
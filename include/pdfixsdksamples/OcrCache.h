@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <filesystem>
+#include <unordered_map>
+#include "Pdfix.h"
+#include "OcrTesseract.h"
+#include "ImageBuffer.h"
+#include "CancelToken.h"
+#include "OcrPreprocess.h"
+
+using namespace PDFixSDK;
+
+// OcrRegionCache recognizes rendered regions on pages of a scratch document and keeps their text
+// layers as form XObjects of the target document. A region with the same pixels is recognized
+// once, the form is placed again for every repeat.
+// With a cache directory the text layers are also kept on disk as one-page PDF files named by the
+// key, so unchanged scans are not recognized again in later runs. The key covers the region
+// pixels, the zoom, the color mode, the preprocessing, the language, the data path and the OCR
+// engine version.
+// The directory is not trimmed.
+class OcrRegionCache {
+public:
+  OcrRegionCache(
+      OcrTesseract* ocr,                            // initialized OCR engine
+      PdfDoc* doc,                                  // document receiving the text
+      const std::wstring& language,                 // OCR language set on the engine
+      const std::wstring& data_path,                // OCR data path set on the engine
+      const std::wstring& cache_dir                 // directory for OCR results, empty for none
+      );
+
+  // Enables preprocessing of regions between rendering and OCR, the parameters become part of the
+  // key.
+  void SetPreprocess(const OcrPreprocess::Params& params);
+
+  // Returns the text layer of the rendered region, a form of width x height points. With
+  // preprocessing a recognized image is cleaned up in place.
+  PdsStream* GetTextLayer(
+      PsImage* image,                               // rendered region
+      int image_width,                              // image width in pixels
+      int image_height,                             // image height in pixels
+      double width,                                 // region width in points
+      double height,                                // region height in points
+      double zoom,                                  // zoom the region was rendered with
+      int page_rotate,                              // page rotation in quarter turns
+      const ImageBufferFormat color_mode,           // color mode of the image passed to OCR
+      CancelToken* cancel                           // cancel token or nullptr
+      );
+
+  int GetHits() const { return hits_; }
+  int GetDiskHits() const { return disk_hits_; }
+  int GetMisses() const { return misses_; }
+
+private:
+  PdsStream* Load(const std::string& name);
+  void Store(const std::string& name);
+
+  PdfDoc* doc_;
+  uint64_t engine_hash_;
+  uint64_t settings_hash_;
+  bool preprocess_enabled_ = false;
+  OcrPreprocess::Params preprocess_;
+  std::filesystem::path dir_;
+  std::unique_ptr<PdfDoc, void (*)(PdfDoc*)> ocr_pdf_;
+  std::unique_ptr<TesseractDoc, void (*)(TesseractDoc*)> ocr_doc_;
+  std::unordered_map<uint64_t, PdsStream*> text_layers_;
+  int hits_ = 0;
+  int disk_hits_ = 0;
+  int misses_ = 0;
+};
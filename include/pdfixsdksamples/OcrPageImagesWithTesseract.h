@@ -4,15 +4,40 @@
 #include <iostream>
 #include <vector>
 #include "Pdfix.h"
+#include "OcrTesseract.h"
+#include "OcrCache.h"
+#include "ImageBuffer.h"
+#include "CancelToken.h"
 
 using namespace PDFixSDK;
 
 void parse_page_element(PdeElement* elem, std::vector<PdfRect>& image_bbox_arr);
+
+// Merges rectangles which overlap or are at most gap pixels apart.
+void MergeDevRects(std::vector<PdfDevRect>& rects, int gap);
+
+// OCRs the image regions of the page, overlapping and adjacent images are merged into one region.
+// Each region is rendered at GetOcrZoom, the native resolution of its images up to zoom. The text
+// is added to the page. Returns the number of regions.
+int OcrPageImages(
+    OcrRegionCache& cache,                          // OCR results of the document
+    PdfPage* page,                                  // page to recognize
+    const double zoom,                              // max zoom to control page rendering quality
+    const PdfRotate rotate,                         // page rotation to be applied
+    const ImageBufferFormat color_mode,             // color mode of the image passed to OCR
+    CancelToken* cancel                             // cancel token or nullptr
+    );
+
+// OCRs image regions of all pages. With preprocess the rendered regions are cleaned up before OCR.
 void OcrPageImagesWithTesseract(
     const std::wstring& open_path,                  // source PDF document
     const std::wstring& save_path,                  // searchable PDF document
     const std::wstring& data_path,                  // path to OCR data
     const std::wstring& language,                   // default OCR language
     const double zoom,                              // zoom to control page rendering quality
-    const PdfRotate rotate                          // page rotation to be applied
+    const PdfRotate rotate,                         // page rotation to be applied
+    const ImageBufferFormat color_mode,             // color mode of the image passed to OCR
+    CancelToken* cancel,                            // cancel token or nullptr
+    const std::wstring& cache_dir,                  // directory for OCR results, empty for none
+    const OcrPreprocess::Params* preprocess = nullptr // preprocessing steps or nullptr
     );
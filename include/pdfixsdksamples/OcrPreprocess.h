@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include "Pdfix.h"
+#include "ImageBuffer.h"
+#include "CancelToken.h"
+
+using namespace PDFixSDK;
+
+namespace OcrPreprocess {
+// binarization of the preprocessed image
+enum Binarization {
+  kBinarizeNone = 0,                            // keep grayscale
+  kBinarizeOtsu = 1,                            // one global threshold, clean scans
+  kBinarizeSauvola = 2,                         // local threshold, uneven background and faxes
+};
+
+// preprocessing steps between rendering and OCR
+struct Params {
+  Binarization binarization = kBinarizeSauvola; // binarization method
+  int window = 0;                               // Sauvola window in pixels, 0 for 1/40 of the width
+  double k = 0.34;                              // Sauvola sensitivity
+  bool deskew = true;                           // straighten skewed text lines
+  double max_skew = 5;                          // max detected skew in degrees
+  bool despeckle = true;                        // remove isolated black pixels
+  bool remove_border = true;                    // remove dark scanner bands along the edges
+  int max_border = 0;                           // border band in pixels, 0 for 1/20 of the size
+};
+
+// Mixes the parameters into the hash, e.g. to key cached OCR results.
+uint64_t HashParams(const Params& params, uint64_t hash);
+
+// Cleans up the gray page image for OCR into a new gray or bitonal buffer. Returns the rotation in
+// degrees applied by deskew, 0 when the image was not rotated.
+double PreprocessImage(
+    const ImageBuffer& gray,                    // kImageBufferGray page or region
+    const Params& params,                       // preprocessing steps
+    ImageBuffer& output                         // preprocessed image
+    );
+
+// Cleans up the rendered image for OCR in place. PsImage holds ARGB pixels only, the binarized or
+// gray result is written back as gray ARGB. When the image is deskewed the rotation is prepended
+// to matrix, which maps the image to the page, so the text still lands on the page content.
+void PreprocessOcrImage(
+    PsImage* image,                             // rendered page or region
+    int width,                                  // image width in pixels
+    int height,                                 // image height in pixels
+    const Params& params,                       // preprocessing steps
+    PdfMatrix& matrix                           // OCR image to page matrix
+    );
+
+// Makes the document searchable, pages are preprocessed between rendering and OCR.
+void Run(
+    const std::wstring& open_path,              // source PDF document
+    const std::wstring& save_path,              // searchable PDF document
+    const std::wstring& data_path,              // path to OCR data
+    const std::wstring& language,               // default OCR language
+    double zoom,                                // max page zoom level for rendering
+    PdfRotate rotate,                           // page rotation
+    const Params& params,                       // preprocessing steps
+    CancelToken* cancel                         // cancel token or nullptr
+    );
+}
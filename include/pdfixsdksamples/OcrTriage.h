@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include "Pdfix.h"
+#include "ImageBuffer.h"
+#include "CancelToken.h"
+
+using namespace PDFixSDK;
+
+namespace OcrTriage {
+// what a page needs from OCR
+enum PageContentClass {
+  kPageBlank = 0,                               // nothing visible, no OCR
+  kPageBornDigital = 1,                         // text and no images, no OCR
+  kPageImageOnly = 2,                           // visible content without text, OCR of the page
+  kPageMixed = 3,                               // text and images, OCR of the image regions
+};
+
+const char* GetPageContentClassName(PageContentClass page_class);
+
+// Returns true when a low resolution gray render of the page has almost no dark pixels.
+bool IsPageBlank(
+    PdfPage* page,                              // page to check
+    double zoom,                                // render zoom, e.g. 0.125 for 9 dpi
+    CancelToken* cancel                         // cancel token or nullptr
+    );
+
+// Classifies the page by its content flags, the blank render is done for pages without text only.
+PageContentClass ClassifyPage(
+    PdfPage* page,                              // page to classify
+    CancelToken* cancel                         // cancel token or nullptr
+    );
+
+// Makes the document searchable, OCR runs only on pages and image regions without text.
+void Run(
+    const std::wstring& open_path,              // source PDF document
+    const std::wstring& save_path,              // searchable PDF document
+    const std::wstring& data_path,              // path to OCR data
+    const std::wstring& language,               // default OCR language
+    double zoom,                                // page zoom level for rendering
+    PdfRotate rotate,                           // page rotation
+    ImageBufferFormat color_mode,               // color mode of the image passed to OCR
+    CancelToken* cancel                         // cancel token or nullptr
+    );
+}
@@ -2,15 +2,86 @@
 
 #include <string>
 #include <iostream>
+#include <vector>
 #include "Pdfix.h"
+#include "ImageBuffer.h"
+#include "CancelToken.h"
+#include "OcrTesseract.h"
+#include "OcrCache.h"
+#include "OcrPreprocess.h"
 
 using namespace PDFixSDK;
 
-void OcrWithTesseract(
+// Returns the zoom to render the area for OCR. It's the native resolution of the images covering at
+// least half of the area, capped at max_zoom, so scans are not upsampled beyond their resolution.
+// A min_zoom above 0 opts in to upsampling low resolution images to it. Areas without such images
+// use max_zoom.
+double GetOcrZoom(
+    PdfPage* page,                                  // page to recognize
+    const PdfRect& area,                            // page area to recognize
+    const double max_zoom,                          // zoom of the target resolution
+    const double min_zoom = 0                       // zoom floor for low resolution images, 0 for none
+    );
+
+// Returns the PdfRenderFlags to render a page for OCR in the color mode. Annotations are rendered
+// and gray pixels come natively from kRenderGrayscale. PsImage holds ARGB pixels only, so bitonal
+// OCR input is not supported, a thresholded copy would cost more than the gray original.
+int GetOcrRenderFlags(const ImageBufferFormat color_mode);
+
+// Renders the page and recognizes it, the text is added to ocr_page which has the page size. The
+// page itself can be the ocr_page. The page is rendered at GetOcrZoom of the crop box. With
+// preprocess the rendered image is cleaned up before OCR.
+void OcrPage(
+    TesseractDoc* ocr_doc,                          // OCR engine of ocr_page document
+    PdfPage* page,                                  // page to recognize
+    PdfPage* ocr_page,                              // page receiving the text
+    const double max_zoom,                          // max page zoom level for rendering
+    const PdfRotate rotate,                         // page rotation
+    const ImageBufferFormat color_mode,             // color mode of the image passed to OCR
+    CancelToken* cancel,                            // cancel token or nullptr
+    const OcrPreprocess::Params* preprocess = nullptr // preprocessing steps or nullptr
+    );
+
+// Renders the whole page at GetOcrZoom and adds its text layer from the cache, the page is recognized
+// only when the rendered pixels are not in the cache.
+void OcrPageCached(
+    OcrRegionCache& cache,                          // OCR results
+    PdfPage* page,                                  // page to recognize
+    const double max_zoom,                          // max page zoom level for rendering
+    const PdfRotate rotate,                         // page rotation
+    const ImageBufferFormat color_mode,             // color mode of the image passed to OCR
+    CancelToken* cancel                             // cancel token or nullptr
+    );
+
+// Makes the document searchable. Pages taking longer than page_timeout are left without text and
+// their numbers are returned. With preprocess the rendered pages are cleaned up before OCR.
+std::vector<int> OcrWithTesseract(
+    const std::wstring& open_path,                  // source PDF document
+    const std::wstring& save_path,                  // searchable PDF document
+    const std::wstring& data_path,                  // path to OCR data
+    const std::wstring& language,                   // default OCR language
+    const double zoom,                              // max page zoom level for rendering to control image processing quality
+    const PdfRotate rotate,                         // page rotation
+    const ImageBufferFormat color_mode,             // color mode of the image passed to OCR
+    CancelToken* cancel,                            // cancel token of the whole job or nullptr
+    const int page_timeout,                         // time budget per page in milliseconds, 0 for none
+    const std::wstring& cache_dir,                  // directory for OCR results, empty for none
+    const OcrPreprocess::Params* preprocess = nullptr // preprocessing steps or nullptr
+    );
+
+// Makes the document searchable with a pool of OCR workers. Each worker renders pages of its own
+// copy of the document and recognizes them with its own OCR document into a scratch document.
+// When all workers finished, the text layers are added to the pages on the calling thread and the
+// document is saved once.
+std::vector<int> OcrWithTesseractParallel(
     const std::wstring& open_path,                  // source PDF document
     const std::wstring& save_path,                  // searchable PDF document
     const std::wstring& data_path,                  // path to OCR data
     const std::wstring& language,                   // default OCR language
-    const double zoom,                              // page zoom level for rendering to control image processing quality
-    const PdfRotate rotate                          // page rotation
+    const double zoom,                              // max page zoom level for rendering
+    const PdfRotate rotate,                         // page rotation
+    const ImageBufferFormat color_mode,             // color mode of the image passed to OCR
+    const size_t thread_count,                      // number of OCR workers
+    CancelToken* cancel,                            // cancel token of the whole job or nullptr
+    const int page_timeout                          // time budget per page in milliseconds, 0 for none
     );
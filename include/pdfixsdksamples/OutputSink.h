@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <ostream>
+#include <thread>
+#include <exception>
+#include "BoundedQueue.h"
+
+// output file compression
+enum OutputCompression {
+  kOutputPlain,                         // the data are written as they are
+  kOutputGzip,                          // gzip member, stored blocks when built without zlib
+};
+
+// Returns kOutputGzip for paths ending with .gz, otherwise kOutputPlain.
+OutputCompression GetOutputCompression(const std::wstring& path);
+
+// OutputSink is an output file stream which hands the written data in chunks to its own thread
+// for compression and writing, so extraction is not blocked by compression and disk I/O. At most
+// a few chunks wait in the queue. Close waits for the thread and throws its error, the destructor
+// closes the sink and ignores errors.
+class OutputSink : public std::ostream {
+public:
+  OutputSink(
+      const std::wstring& path,         // output file
+      OutputCompression compression,    // output file compression
+      int level = 6,                    // compression level 1 to 9
+      size_t chunk_size = 1 << 18       // size of the data handed to the compression thread
+      );
+  ~OutputSink();
+
+  // Flushes the data and closes the file.
+  void Close();
+
+private:
+  class Encoder;
+  class Buffer : public std::streambuf {
+  public:
+    Buffer(OutputSink& sink, size_t chunk_size);
+    bool Flush();
+  protected:
+    int_type overflow(int_type ch) override;
+    int sync() override;
+  private:
+    OutputSink& sink_;
+    std::vector<char> chunk_;
+  };
+
+  void Compress();
+
+  std::unique_ptr<Encoder> encoder_;
+  BoundedQueue<std::vector<char>> queue_;
+  Buffer buffer_;
+  std::thread thread_;
+  std::exception_ptr error_;
+  bool closed_ = false;
+};
@@ -2,13 +2,16 @@
 
 #include <string>
 #include <iostream>
+#include <unordered_set>
 #include "Pdfix.h"
 
 using namespace PDFixSDK;
 
 namespace ParsePageContent {
-// ProcessObject gets the value of the object.
-void ProcessPageObject(PdsPageObject* obj, std::ostream& ss, std::string indent);
+// ProcessObject gets the value of the object. The kids of a Form XObject are listed at its first
+// use only, forms holds the ids of the listed ones.
+void ProcessPageObject(PdsPageObject* obj, std::ostream& ss, std::string indent,
+    std::unordered_set<int>& forms);
 
 // Iterates all documents bookmars.
 void Run(
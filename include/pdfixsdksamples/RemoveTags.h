@@ -1,8 +1,10 @@
 #pragma once
 
 #include <string>
+#include "CancelToken.h"
 
 void RemoveTags(
     const std::wstring& open_path,        // source PDF document
-    const std::wstring& save_path        // output PDF document
+    const std::wstring& save_path,       // output PDF document
+    CancelToken* cancel = nullptr         // cancel token or nullptr
     );
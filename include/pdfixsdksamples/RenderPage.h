@@ -1,7 +1,11 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <cstdint>
 #include "Pdfix.h"
+#include "ImageBuffer.h"
+#include "CancelToken.h"
 
 using namespace PDFixSDK;
 
@@ -14,3 +18,74 @@ void RenderPage(
     PdfRotate rotate,                           // page rotation
     PdfDevRect clip_rect                        // clip region
     );
+
+// Renders the page in the grayscale or bitonal mode into a PNG with 8-bit or 1-bit pixels.
+void RenderPageGray(
+    const std::wstring& open_path,              // source PDF document
+    const std::wstring& img_path,               // output PNG image
+    int page_num,                               // page number
+    double zoom,                                // page zoom
+    PdfRotate rotate,                           // page rotation
+    PdfDevRect clip_rect,                       // clip region
+    ImageBufferFormat format                    // kImageBufferGray or kImageBufferBitonal
+    );
+
+// Renders the page or its clip_rect area into a new kImageDIBFormatArgb image. The caller
+// destroys the image, width and height receive its size.
+PsImage* RenderPageImage(
+    PdfPage* page,                              // page to render
+    double zoom,                                // page zoom
+    PdfRotate rotate,                           // page rotation
+    PdfDevRect clip_rect,                       // clip region, empty for the whole page
+    int render_flags,                           // PdfRenderFlags, e.g. kRenderGrayscale
+    int& width,                                 // rendered image width
+    int& height,                                // rendered image height
+    CancelToken* cancel                         // cancel token or nullptr
+    );
+
+// Renders the page and writes the encoded image into the stream, e.g. a PsMemStream.
+void RenderPageToStream(
+    PdfPage* page,                              // page to render
+    PsStream* stream,                           // output stream
+    PdfImageParams img_params,                  // output image params
+    double zoom,                                // page zoom
+    PdfRotate rotate,                           // page rotation
+    PdfDevRect clip_rect,                       // clip region, empty for the whole page
+    CancelToken* cancel                         // cancel token or nullptr
+    );
+
+// Renders the page and returns the encoded image bytes.
+std::vector<uint8_t> RenderPageToMemory(
+    PdfPage* page,                              // page to render
+    PdfImageParams img_params,                  // output image params
+    double zoom,                                // page zoom
+    PdfRotate rotate,                           // page rotation
+    PdfDevRect clip_rect,                       // clip region, empty for the whole page
+    CancelToken* cancel                         // cancel token or nullptr
+    );
+
+// Renders the page and copies the encoded image into the caller-supplied buffer. Returns the
+// encoded size, the buffer is left untouched when the size is bigger than buffer_size.
+size_t RenderPageToBuffer(
+    PdfPage* page,                              // page to render
+    PdfImageParams img_params,                  // output image params
+    double zoom,                                // page zoom
+    PdfRotate rotate,                           // page rotation
+    PdfDevRect clip_rect,                       // clip region, empty for the whole page
+    uint8_t* buffer,                            // output buffer
+    size_t buffer_size,                         // output buffer size
+    CancelToken* cancel                         // cancel token or nullptr
+    );
+
+// Renders the page and returns raw pixels for callers that encode the image themselves. Gray and
+// bitonal pixels are rendered with kRenderGrayscale and converted with ConvertToGray and
+// ThresholdAdaptive.
+void RenderPagePixels(
+    PdfPage* page,                              // page to render
+    double zoom,                                // page zoom
+    PdfRotate rotate,                           // page rotation
+    PdfDevRect clip_rect,                       // clip region, empty for the whole page
+    ImageBufferFormat format,                   // output pixel format
+    ImageBuffer& pixels,                        // output pixels
+    CancelToken* cancel                         // cancel token or nullptr
+    );
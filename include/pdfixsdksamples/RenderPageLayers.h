@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <set>
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+namespace RenderPageLayers {
+// layers and object types switched off for a render
+struct LayerSelection {
+  std::set<int> hidden_layers;                  // object ids of OCG dictionaries, see ReadOCGLayers
+  std::set<int> hidden_types;                   // PdfPageObjectType values, e.g. kPdsPageText
+};
+
+// PageLayerMask indexes the page objects, including objects nested in forms, together with the
+// optional content groups that control them. The content tree is walked once, each Apply then only
+// flips render flags of the indexed objects, so one mask serves renders of any zoom and selection.
+// The page must outlive the mask, the mask holds the acquired contents of the forms so that their
+// objects stay valid.
+class PageLayerMask {
+public:
+  explicit PageLayerMask(PdfPage* page);
+
+  // Sets the render flag of each page object according to the selection.
+  void Apply(const LayerSelection& selection);
+
+  size_t GetNumObjects() const { return items_.size(); }
+
+private:
+  struct Item {
+    PdsPageObject* object;
+    PdfPageObjectType type;
+    std::vector<size_t> groups;                 // indices of groups_, all must be visible
+    bool rendered;
+  };
+
+  void AddObject(PdsPageObject* object, const std::vector<size_t>& parent_groups);
+
+  std::vector<Item> items_;
+  // contents of the forms, acquired for the lifetime of the mask
+  std::vector<std::unique_ptr<PdsContent, void (*)(PdsContent*)>> form_contents_;
+  std::vector<std::vector<int>> groups_;        // OCG ids of one OC mark, visible if any is visible
+  bool applied_ = false;                        // render flags were set at least once
+};
+
+// Renders the page once per layer with only that layer visible, at each zoom. Images are named
+// <img_path>layer<ocg id>_<zoom index>.png.
+void Run(
+    const std::wstring& open_path,              // source PDF document
+    const std::wstring& img_path,               // output image path prefix
+    int page_num,                               // page number
+    const std::vector<double>& zooms,           // page zooms
+    PdfRotate rotate                            // page rotation
+    );
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include "Pdfix.h"
+#include "ImageBuffer.h"
+#include "CancelToken.h"
+
+using namespace PDFixSDK;
+
+namespace RenderPageTiles {
+// Renders a single tile of the page view into the buffer. Only the tile area is rasterised.
+void RenderTile(
+    PdfPage* page,                              // page to render
+    PdfPageView* page_view,                     // page view defining zoom and rotation
+    int col,                                    // tile column
+    int row,                                    // tile row
+    int tile_size,                              // tile width and height in pixels
+    ImageBuffer& tile,                          // output tile pixels
+    CancelToken* cancel = nullptr               // cancel token or nullptr
+    );
+
+// Renders the page into a DeepZoom (DZI) tile pyramid. Only the deepest level is rendered, lower
+// levels are built by downsampling, and at most one tile branch per level is held in memory.
+void Run(
+    const std::wstring& open_path,              // source PDF document
+    const std::wstring& save_path,              // output .dzi file, tiles go to <name>_files
+    int page_num,                               // page number
+    double zoom,                                // page zoom of the deepest level
+    PdfRotate rotate,                           // page rotation
+    int tile_size,                              // tile width and height in pixels
+    CancelToken* cancel = nullptr               // cancel token or nullptr
+    );
+}
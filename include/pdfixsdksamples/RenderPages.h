@@ -1,11 +1,16 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include "Pdfix.h"
+#include "CancelToken.h"
+#include "ImageBuffer.h"
 
 using namespace PDFixSDK;
 
-void RenderPages(
+// Renders pages in parallel. Pages rendering longer than page_timeout are skipped, their numbers
+// are returned.
+std::vector<int> RenderPages(
     const std::wstring& open_path,              // source PDF document
     const std::wstring& img_path,               // output image
     PdfImageParams img_params,                  // output image params
@@ -14,5 +19,47 @@ void RenderPages(
     double zoom,                                // page zoom
     PdfRotate rotate,                           // page rotation
     PdfDevRect clip_rect,                       // clip region
-    size_t thread_count                         // max number of threads
+    size_t thread_count,                        // max number of threads
+    CancelToken* cancel,                        // cancel token of the whole job or nullptr
+    int page_timeout                            // time budget per page in milliseconds, 0 for none
+    );
+
+// Renders pages with a three-stage pipeline: render workers, an encoder pool and an async file
+// writer connected with bounded queues. Returns numbers of pages skipped over page_timeout.
+std::vector<int> RenderPagesPipelined(
+    const std::wstring& open_path,              // source PDF document
+    const std::wstring& img_path,               // output image
+    PdfImageParams img_params,                  // output image params
+    int page_from,                              // page from
+    int page_to,                                // page to
+    double zoom,                                // page zoom
+    PdfRotate rotate,                           // page rotation
+    PdfDevRect clip_rect,                       // clip region
+    size_t render_threads,                      // number of render threads
+    size_t encode_threads,                      // number of encoder threads
+    size_t queue_size,                          // max number of rendered pages waiting for encoder
+    CancelToken* cancel,                        // cancel token of the whole job or nullptr
+    int page_timeout                            // time budget per page in milliseconds, 0 for none
+    );
+
+// one output size of RenderPagesMultiResolution
+struct RenderPageVariant {
+  double zoom;                                  // page zoom of the variant
+  std::wstring suffix;                          // file name suffix, e.g. L"_thumb"
+};
+
+// Rasterises each page once at the highest zoom of the variants and derives the smaller sizes by
+// resampling, all variants of a page are written as PNG in one pass. Returns numbers of pages
+// skipped over page_timeout.
+std::vector<int> RenderPagesMultiResolution(
+    const std::wstring& open_path,              // source PDF document
+    const std::wstring& img_path,               // output image path prefix
+    int page_from,                              // page from
+    int page_to,                                // page to
+    PdfRotate rotate,                           // page rotation
+    const std::vector<RenderPageVariant>& variants, // output sizes
+    ImageResampleFilter filter,                 // downscaling filter
+    size_t thread_count,                        // number of render threads
+    CancelToken* cancel,                        // cancel token of the whole job or nullptr
+    int page_timeout                            // time budget per page in milliseconds, 0 for none
     );
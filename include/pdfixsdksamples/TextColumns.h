@@ -0,0 +1,114 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include "MappedFile.h"
+#include "CancelToken.h"
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+// Columnar export of the text elements, lines and words of the page map. One row per element,
+// each field is a contiguous typed column, so the file is used through mmap without parsing.
+//
+// File layout, numbers in the byte order of the writer (little-endian on x86 and ARM), columns
+// padded to 8 bytes:
+//   char     magic[8]                "PDFIXTC1"
+//   row groups, each of them:
+//     uint64   num_rows
+//     int32    page[num_rows]        page number
+//     int32    parent[num_rows]      file row index of the parent line or text element, -1 for none
+//     float32  left[num_rows]        bbox in PDF coordinates, 4 columns
+//     float32  bottom[num_rows]
+//     float32  right[num_rows]
+//     float32  top[num_rows]
+//     uint32   text_offset[num_rows] byte offset of the element in the text section
+//     uint32   text_length[num_rows] UTF-8 length of the element text
+//     int32    style[num_rows]       index into the styles, -1 when unknown
+//     uint8    type[num_rows]        kPdeText, kPdeTextLine or kPdeWord
+//   char     text[text_size]         UTF-8 words, separated by spaces and line breaks
+//   char     styles[styles_size]     JSON {"styles": [...]} with the text styles of ExtractData
+//   uint64   row_group_offsets[num_row_groups]
+//   trailer: uint64 num_rows, num_row_groups, row_groups_offset, text_offset, text_size,
+//            styles_offset, styles_size; char magic[8] "PDFIXTC1"
+namespace TextColumns {
+  // columns of one row group, pointing into the mapped file
+  struct RowGroup {
+    size_t num_rows = 0;
+    const int32_t* page = nullptr;
+    const int32_t* parent = nullptr;
+    const float* left = nullptr;
+    const float* bottom = nullptr;
+    const float* right = nullptr;
+    const float* top = nullptr;
+    const uint32_t* text_offset = nullptr;
+    const uint32_t* text_length = nullptr;
+    const int32_t* style = nullptr;
+    const uint8_t* type = nullptr;
+  };
+
+  // Writer collects rows in column buffers and writes them as a row group when it's full.
+  class Writer {
+  public:
+    Writer(
+        const std::wstring& save_path,  // output file
+        size_t row_group_size           // rows per row group
+        );
+
+    // Appends the element text to the text section, returns its offset.
+    uint32_t AddText(const std::string& text);
+
+    // Adds a row, returns its file row index used as the parent of other rows.
+    int32_t AddRow(int page, int32_t parent, const PdfRect& bbox, uint32_t text_offset,
+      uint32_t text_length, int style, PdfElementType type);
+
+    // Writes the remaining rows, the text, styles and the trailer.
+    void Close(const std::string& styles);
+
+  private:
+    void FlushRowGroup();
+    template <typename T> void WriteColumn(const std::vector<T>& column);
+    void Write(const void* data, size_t size);
+
+    std::ofstream file_;
+    uint64_t offset_ = 0;
+    size_t row_group_size_;
+    uint64_t num_rows_ = 0;
+    std::vector<uint64_t> row_group_offsets_;
+    std::string text_;
+    std::vector<int32_t> page_, parent_, style_;
+    std::vector<float> left_, bottom_, right_, top_;
+    std::vector<uint32_t> text_offset_, text_length_;
+    std::vector<uint8_t> type_;
+  };
+
+  // Reader maps the file and returns the columns in place.
+  class Reader {
+  public:
+    explicit Reader(const std::wstring& path);
+
+    uint64_t GetNumRows() const { return num_rows_; }
+    size_t GetNumRowGroups() const { return row_group_offsets_.size(); }
+    RowGroup GetRowGroup(size_t index) const;
+    std::string GetText(uint32_t offset, uint32_t length) const;
+    std::string GetStyles() const;
+
+  private:
+    MappedFile file_;
+    uint64_t num_rows_ = 0;
+    std::vector<uint64_t> row_group_offsets_;
+    uint64_t text_offset_ = 0, text_size_ = 0;
+    uint64_t styles_offset_ = 0, styles_size_ = 0;
+  };
+
+  // Exports the text elements, lines and words of all pages.
+  void Run(
+      const std::wstring& open_path,    // source PDF document
+      const std::wstring& save_path,    // output columnar file
+      const std::wstring& config_path,  // configuration file
+      size_t row_group_size,            // rows per row group
+      CancelToken* cancel = nullptr     // cancel token or nullptr
+      );
+}
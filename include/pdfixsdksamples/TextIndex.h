@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "MappedFile.h"
+#include "CancelToken.h"
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+// Full-text inverted index of the page map words, stored next to the PDF and searched in place
+// through mmap. Words are split into lowercase tokens of letters and digits, a token position is
+// its index among the tokens of the page.
+//
+// File layout, numbers in the byte order of the writer (little-endian on x86 and ARM):
+//   char     magic[8]                "PDFIXTI1"
+//   postings of each term: varint count, then for each occurrence varint page delta and varint
+//            position, the position is a delta from the previous one on the same page
+//   char     terms[]                 UTF-8 terms without separators
+//   terms table sorted by term, aligned to 8 bytes, each entry:
+//            uint32 term_offset, uint32 term_length, uint64 postings_offset
+//   trailer: uint64 num_terms, terms_table_offset, terms_offset, pdf_hash; char magic[8]
+namespace TextIndex {
+  // occurrence of a token or of the first token of a phrase
+  struct Hit {
+    int page_num;
+    uint32_t position;
+  };
+
+  // Splits the text into lowercase tokens of letters and digits.
+  std::vector<std::string> Tokenize(const std::wstring& text);
+
+  // Builds the index of all pages of the document.
+  void Build(
+      PdfDoc* doc,                      // indexed document
+      uint64_t pdf_hash,                // hash of the PDF file, tells if the index is current
+      const std::wstring& index_path,   // output index file
+      CancelToken* cancel = nullptr     // cancel token or nullptr
+      );
+
+  // Reader maps the index file, the terms are looked up by binary search in place.
+  class Reader {
+  public:
+    explicit Reader(const std::wstring& index_path);
+
+    uint64_t GetPdfHash() const { return pdf_hash_; }
+    size_t GetNumTerms() const { return (size_t)num_terms_; }
+
+    // Returns the occurrences of the query, tokens of a phrase must follow each other on a page.
+    std::vector<Hit> Find(const std::wstring& query) const;
+
+  private:
+    std::vector<Hit> FindTerm(const std::string& term) const;
+
+    MappedFile file_;
+    uint64_t num_terms_ = 0;
+    uint64_t terms_table_offset_ = 0;
+    uint64_t terms_offset_ = 0;
+    uint64_t pdf_hash_ = 0;
+  };
+
+  // Builds the index next to the document, <open_path>.idx, unless it is current, and prints the
+  // pages and positions of the query.
+  void Run(
+      const std::wstring& open_path,    // source PDF document
+      const std::wstring& query,        // searched word or phrase
+      CancelToken* cancel = nullptr     // cancel token or nullptr
+      );
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <list>
+#include <mutex>
+#include <cstdint>
+#include <filesystem>
+#include <unordered_map>
+#include "Pdfix.h"
+#include "CancelToken.h"
+
+using namespace PDFixSDK;
+
+namespace Thumbnails {
+  // thumbnail rendering parameters, all of them are part of the cache key
+  struct ThumbnailParams {
+    int width = 256;                        // target box width in pixels
+    int height = 256;                       // target box height in pixels
+    PdfRotate rotate = kRotate0;            // page rotation
+    int render_flags = kRenderAnnot;        // page render flags
+    PdfImageParams img_params;              // output image format and quality
+  };
+
+  // ThumbnailCache keeps encoded thumbnails in a directory and evicts the least recently used
+  // files when the total size exceeds the limit. It is safe to use from multiple threads.
+  class ThumbnailCache {
+  public:
+    ThumbnailCache(
+        const std::wstring& cache_dir,      // directory holding the cached thumbnails
+        uint64_t max_bytes                  // max total size of the cached files
+        );
+
+    // Returns the encoded thumbnail from the cache or renders and stores it.
+    std::vector<uint8_t> Get(PdfDoc* doc, const std::string& doc_hash, int page_num,
+      const ThumbnailParams& params, CancelToken* cancel = nullptr);
+
+    uint64_t GetHits() const { return hits_; }
+    uint64_t GetMisses() const { return misses_; }
+
+  private:
+    struct Entry {
+      std::string name;
+      uint64_t size;
+    };
+    bool Load(const std::string& name, std::vector<uint8_t>& data);
+    void Store(const std::string& name, const std::vector<uint8_t>& data);
+    void Trim();
+
+    std::filesystem::path dir_;
+    uint64_t max_bytes_;
+    uint64_t total_bytes_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    std::list<Entry> lru_;                  // most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    std::mutex mutex_;
+  };
+
+  // Renders the page to fit the target box and returns the encoded image.
+  std::vector<uint8_t> RenderThumbnail(PdfPage* page, const ThumbnailParams& params,
+    CancelToken* cancel = nullptr);
+
+  // Makes thumbnails of all document pages in parallel, pages already in the cache are skipped.
+  void GenerateThumbnails(PdfDoc* doc, const std::string& doc_hash, ThumbnailCache& cache,
+    const ThumbnailParams& params, size_t thread_count, CancelToken* cancel = nullptr);
+
+  // Batch mode, fills the cache with thumbnails of all pages of the document.
+  void Run(
+      const std::wstring& open_path,        // source PDF document
+      const std::wstring& cache_dir,        // thumbnail cache directory
+      uint64_t max_cache_bytes,             // max total size of the cache
+      const ThumbnailParams& params,        // thumbnail parameters
+      size_t thread_count,                  // max number of threads
+      CancelToken* cancel = nullptr         // cancel token or nullptr
+      );
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <cstdint>
 #include "Pdfix.h"
 
 using namespace PDFixSDK;
@@ -10,8 +11,13 @@ using namespace PDFixSDK;
 std::wstring FromUtf8(const std::string& str);
 std::string ToUtf8(const std::wstring& str);
 std::string PsStreamEncodeBase64(PsStream *stream);
+uint64_t Fnv1aHash(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull);
+uint32_t Crc32(const void* data, size_t size, uint32_t crc = 0);
+uint64_t HashFile(const std::wstring& path);
+std::string HashToHex(uint64_t hash);
 void PdfMatrixTransform(PdfMatrix &m, PdfPoint &p);
 void PdfMatrixConcat(PdfMatrix& m, PdfMatrix& m1, bool prepend);
 void PdfMatrixRotate(PdfMatrix& m, double radian, bool prepend);
 void PdfMatrixScale(PdfMatrix& m, double sx, double sy, bool prepend);
 void PdfMatrixTranslate(PdfMatrix& m, double x, double y, bool prepend);
+bool PdfMatrixInverse(const PdfMatrix& m, PdfMatrix& inverse);
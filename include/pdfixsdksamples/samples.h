@@ -4,8 +4,11 @@
 #include "AddTags.h"
 #include "AddWatermark.h"
 #include "BookmarksToJson.h"
+#include "CharIndex.h"
 #include "ConvertToHtml.h"
 #include "ConvertToHtmlEx.h"
+#include "ConvertToHtmlIncremental.h"
+#include "ConvertToHtmlParallel.h"
 #include "DigitalSignature.h"
 #include "DocumentMetadata.h"
 #include "EmbedFonts.h"
@@ -18,11 +21,18 @@
 #include "FillForm.h"
 #include "FlattenAnnots.h"
 #include "GetWhitespace.h"
+#include "HtmlAssetCache.h"
+#include "HtmlPageServer.h"
 #include "Initialization.h"
 #include "MakeAccessible.h"
+#include "MappedFile.h"
+#include "OcrCache.h"
+#include "OcrPreprocess.h"
 #include "OcrPageImagesWithTesseract.h"
 #include "OcrWithTesseract.h"
+#include "OcrTriage.h"
 #include "OpedDocumentFromStream.h"
+#include "OutputSink.h"
 #include "ParsePageContent.h"
 #include "ParsePdsObjects.h"
 #include "PrintPage.h"
@@ -31,5 +41,11 @@
 #include "RegisterEvent.h"
 #include "RemoveComments.h"
 #include "RenderPage.h"
+#include "RenderPages.h"
+#include "RenderPageTiles.h"
+#include "RenderPageLayers.h"
 #include "SetFieldFlags.h"
 #include "SetFormFieldValue.h"
+#include "TextColumns.h"
+#include "TextIndex.h"
+#include "Thumbnails.h"
@@ -15,7 +15,8 @@ void AddTags(
   const std::wstring& open_path,        // source PDF document
   const std::wstring& save_path,        // output PDF document
   const std::wstring& config_path,      // configuration file
-  const bool preflight                  // preflight document template before processing
+  const bool preflight,                 // preflight document template before processing
+  CancelToken* cancel                   // cancel token or nullptr
 ) {
   // initialize Pdfix
   if (!Pdfix_init(Pdfix_MODULE_NAME))
@@ -45,22 +46,30 @@ void AddTags(
   if (preflight) {
     // add reference pages for preflight
     for (auto i = 0; i < doc->GetNumPages(); i++) {
-      if (!doc_template->AddPage(i, nullptr, nullptr))
+      if (!doc_template->AddPage(i, &CancelToken::CancelProc, cancel)) {
+        CancelToken::ThrowIfStopped(cancel);
         throw PdfixException();
+      }
     }
       
     // run document preflight
-    if (!doc_template->Update(nullptr, nullptr))
+    if (!doc_template->Update(&CancelToken::CancelProc, cancel)) {
+      CancelToken::ThrowIfStopped(cancel);
       throw PdfixException();
+    }
   }
 
   // remove old marked content
-  if (!doc->RemoveTags(nullptr, nullptr))
+  if (!doc->RemoveTags(&CancelToken::CancelProc, cancel)) {
+    CancelToken::ThrowIfStopped(cancel);
     throw PdfixException();
+  }
 
   // add tags to the document
-  if (!doc->AddTags(nullptr, nullptr))
+  if (!doc->AddTags(&CancelToken::CancelProc, cancel)) {
+    CancelToken::ThrowIfStopped(cancel);
     throw PdfixException();
+  }
 
   if (!doc->Save(save_path.c_str(), kSaveFull | kSaveCompressedStructureOnly))
     throw PdfixException();
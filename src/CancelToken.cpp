@@ -0,0 +1,57 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// CancelToken.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/CancelToken.h"
+
+#include <chrono>
+
+static long long Now() {
+  return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+CancelToken::CancelToken(
+  const CancelToken* parent,                // parent token or nullptr
+  int timeout                               // time budget in milliseconds, 0 for no deadline
+) : parent_(parent), cancelled_(false), deadline_(0) {
+  SetTimeout(timeout);
+}
+
+void CancelToken::Cancel() {
+  cancelled_ = true;
+}
+
+void CancelToken::SetTimeout(int timeout) {
+  if (timeout <= 0) {
+    deadline_ = 0;
+    return;
+  }
+  auto ticks = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+    std::chrono::milliseconds(timeout)).count();
+  deadline_ = Now() + ticks;
+}
+
+bool CancelToken::IsCancelled() const {
+  return cancelled_ || (parent_ && parent_->IsCancelled());
+}
+
+bool CancelToken::IsExpired() const {
+  long long deadline = deadline_;
+  return (deadline != 0 && Now() >= deadline) || (parent_ && parent_->IsExpired());
+}
+
+int CancelToken::CancelProc(void* data) {
+  auto token = static_cast<const CancelToken*>(data);
+  return token && token->IsStopped() ? 1 : 0;
+}
+
+void CancelToken::ThrowIfStopped(const CancelToken* token) {
+  if (!token)
+    return;
+  // cancellation wins over the deadline, the caller must not skip and continue
+  if (token->IsCancelled())
+    throw CancelException(false);
+  if (token->IsExpired())
+    throw CancelException(true);
+}
@@ -0,0 +1,298 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// CharIndex.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/CharIndex.h"
+
+#include <string>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <filesystem>
+#include "pdfixsdksamples/Utils.h"
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+namespace CharIndex {
+
+  static const char kMagic[8] = { 'P', 'D', 'F', 'I', 'X', 'C', 'I', '1' };
+  static const size_t kPageHeaderSize = 4 * sizeof(float) + 4 * sizeof(uint32_t);
+  static const size_t kTrailerSize = 2 * sizeof(uint64_t) + sizeof(kMagic);
+
+  struct WordRecord {
+    uint32_t text_offset;
+    uint32_t first_quad;
+    uint16_t num_units;
+    uint16_t reserved;
+  };
+  static_assert(sizeof(WordRecord) == 12, "WordRecord must be packed");
+
+  struct QuadRecord {
+    uint16_t left, bottom, right, top;
+  };
+
+  // length of the text in UTF-16 code units
+  static uint32_t Utf16Length(const std::wstring& text) {
+    if (sizeof(wchar_t) == 2)
+      return (uint32_t)text.size();
+    uint32_t length = 0;
+    for (auto ch : text)
+      length += (uint32_t)ch > 0xffff ? 2 : 1;
+    return length;
+  }
+
+  // collects the page map words in reading order with their characters
+  struct PageBuilder {
+    PdfRect box;
+    std::string text;
+    uint32_t units = 0;                     // text length in UTF-16 code units
+    std::vector<WordRecord> words;
+    std::vector<QuadRecord> quads;
+
+    uint16_t Quantise(double value, double origin, double size) const {
+      double q = std::round((value - origin) / size * 65535.);
+      return (uint16_t)std::min(std::max(q, 0.), 65535.);
+    }
+
+    void AddSeparator(char ch) {
+      if (text.empty())
+        return;
+      text += ch;
+      units++;
+    }
+
+    void AddWord(PdeWord* word) {
+      WordRecord record = { units, (uint32_t)quads.size(), 0, 0 };
+      double width = box.right - box.left;
+      double height = box.top - box.bottom;
+      for (int i = 0; i < word->GetNumChars(); i++) {
+        auto char_text = word->GetCharText(i);
+        uint32_t n = Utf16Length(char_text);
+        if (n == 0)
+          continue;
+        PdfRect bbox;
+        if (!word->GetCharBBox(i, &bbox))
+          throw PdfixException();
+        // a ligature gets the equal part of its box for each character
+        for (uint32_t k = 0; k < n; k++) {
+          QuadRecord quad;
+          quad.left = Quantise(bbox.left + (bbox.right - bbox.left) * k / n, box.left, width);
+          quad.right = Quantise(bbox.left + (bbox.right - bbox.left) * (k + 1) / n, box.left,
+            width);
+          quad.bottom = Quantise(bbox.bottom, box.bottom, height);
+          quad.top = Quantise(bbox.top, box.bottom, height);
+          quads.push_back(quad);
+        }
+        text += ToUtf8(char_text);
+        units += n;
+      }
+      record.num_units = (uint16_t)std::min<uint32_t>(units - record.text_offset, 0xffff);
+      if (record.num_units)
+        words.push_back(record);
+    }
+
+    void AddElement(PdeElement* element) {
+      if (element->GetType() == kPdeText) {
+        auto text_elem = (PdeText*)element;
+        AddSeparator('\n');
+        for (int l = 0; l < text_elem->GetNumTextLines(); l++) {
+          auto line = text_elem->GetTextLine(l);
+          if (!line)
+            throw PdfixException();
+          if (l > 0)
+            AddSeparator('\n');
+          for (int w = 0; w < line->GetNumWords(); w++) {
+            auto word = line->GetWord(w);
+            if (!word)
+              throw PdfixException();
+            if (w > 0)
+              AddSeparator(' ');
+            AddWord(word);
+          }
+        }
+        return;
+      }
+      for (int i = 0; i < element->GetNumChildren(); i++) {
+        auto child = element->GetChild(i);
+        if (child)
+          AddElement(child);
+      }
+    }
+  };
+
+  Writer::Writer(const std::wstring& save_path)
+    : file_(std::filesystem::path(save_path), std::ios::binary | std::ios::trunc) {
+    if (!file_)
+      throw std::runtime_error("Char index file open fail");
+    Write(kMagic, sizeof(kMagic));
+  }
+
+  void Writer::Write(const void* data, size_t size) {
+    if (size && !file_.write((const char*)data, size))
+      throw std::runtime_error("Char index file write fail");
+    offset_ += size;
+  }
+
+  std::string Writer::AddPage(PdfPage* page, PdeElement* element) {
+    PageBuilder builder;
+    builder.box = page->GetCropBox();
+    if (builder.box.right <= builder.box.left || builder.box.top <= builder.box.bottom)
+      throw std::runtime_error("Invalid page crop box");
+    builder.AddElement(element);
+
+    static const char padding[8] = { 0 };
+    Write(padding, (8 - offset_ % 8) % 8);
+    pages_.push_back(std::make_pair(offset_, page->GetNumber()));
+
+    float box[] = { (float)builder.box.left, (float)builder.box.bottom,
+      (float)(builder.box.right - builder.box.left), (float)(builder.box.top - builder.box.bottom) };
+    uint32_t counts[] = { (uint32_t)builder.words.size(), (uint32_t)builder.quads.size(),
+      (uint32_t)builder.text.size(), 0 };
+    Write(box, sizeof(box));
+    Write(counts, sizeof(counts));
+    Write(builder.words.data(), builder.words.size() * sizeof(WordRecord));
+    Write(builder.quads.data(), builder.quads.size() * sizeof(QuadRecord));
+    Write(builder.text.data(), builder.text.size());
+    return builder.text;
+  }
+
+  void Writer::Close() {
+    static const char padding[8] = { 0 };
+    Write(padding, (8 - offset_ % 8) % 8);
+    uint64_t pages_offset = offset_;
+    for (auto& page : pages_) {
+      uint32_t page_num[] = { (uint32_t)page.second, 0 };
+      Write(&page.first, sizeof(page.first));
+      Write(page_num, sizeof(page_num));
+    }
+    uint64_t trailer[] = { pages_.size(), pages_offset };
+    Write(trailer, sizeof(trailer));
+    Write(kMagic, sizeof(kMagic));
+    file_.close();
+    if (!file_)
+      throw std::runtime_error("Char index file write fail");
+  }
+
+  // page section in the mapped file
+  struct Reader::Page {
+    float left, bottom, width, height;
+    uint32_t num_words, num_quads, text_size;
+    const uint8_t* words;
+    const uint8_t* quads;
+    const char* text;
+
+    WordRecord GetWord(uint32_t index) const {
+      WordRecord word;
+      memcpy(&word, words + (size_t)index * sizeof(WordRecord), sizeof(word));
+      return word;
+    }
+    QuadRecord GetQuad(uint32_t index) const {
+      QuadRecord quad;
+      memcpy(&quad, quads + (size_t)index * sizeof(QuadRecord), sizeof(quad));
+      return quad;
+    }
+  };
+
+  Reader::Reader(const std::wstring& path) : file_(path) {
+    auto data = file_.GetData();
+    auto size = file_.GetSize();
+    if (size < sizeof(kMagic) + kTrailerSize || memcmp(data, kMagic, sizeof(kMagic)) != 0 ||
+      memcmp(data + size - sizeof(kMagic), kMagic, sizeof(kMagic)) != 0)
+      throw std::runtime_error("Not a char index file");
+
+    uint64_t trailer[2];
+    memcpy(trailer, data + size - kTrailerSize, sizeof(trailer));
+    uint64_t end = size - kTrailerSize;
+    if (trailer[1] > end || trailer[0] > (end - trailer[1]) / 16)
+      throw std::runtime_error("Damaged char index file");
+    for (uint64_t i = 0; i < trailer[0]; i++) {
+      uint64_t offset;
+      uint32_t page_num;
+      memcpy(&offset, data + trailer[1] + i * 16, sizeof(offset));
+      memcpy(&page_num, data + trailer[1] + i * 16 + 8, sizeof(page_num));
+      if (offset > trailer[1] || trailer[1] - offset < kPageHeaderSize)
+        throw std::runtime_error("Damaged char index file");
+      pages_.push_back(std::make_pair(offset, (int)page_num));
+    }
+  }
+
+  bool Reader::HasPage(int page_num) const {
+    return std::any_of(pages_.begin(), pages_.end(),
+      [&](const std::pair<uint64_t, int>& page) { return page.second == page_num; });
+  }
+
+  Reader::Page Reader::GetPage(int page_num) const {
+    auto it = std::find_if(pages_.begin(), pages_.end(),
+      [&](const std::pair<uint64_t, int>& page) { return page.second == page_num; });
+    if (it == pages_.end())
+      throw std::out_of_range("Page not in the char index");
+
+    auto data = file_.GetData() + it->first;
+    Page page;
+    memcpy(&page.left, data, 4 * sizeof(float));
+    uint32_t counts[4];
+    memcpy(counts, data + 4 * sizeof(float), sizeof(counts));
+    page.num_words = counts[0];
+    page.num_quads = counts[1];
+    page.text_size = counts[2];
+    uint64_t available = file_.GetSize() - kTrailerSize - it->first - kPageHeaderSize;
+    if ((uint64_t)page.num_words * sizeof(WordRecord) + (uint64_t)page.num_quads *
+      sizeof(QuadRecord) + page.text_size > available)
+      throw std::runtime_error("Damaged char index file");
+    page.words = data + kPageHeaderSize;
+    page.quads = page.words + (size_t)page.num_words * sizeof(WordRecord);
+    page.text = (const char*)page.quads + (size_t)page.num_quads * sizeof(QuadRecord);
+    return page;
+  }
+
+  std::string Reader::GetPageText(int page_num) const {
+    auto page = GetPage(page_num);
+    return std::string(page.text, page.text_size);
+  }
+
+  std::vector<PdfRect> Reader::GetQuads(int page_num, uint32_t offset, uint32_t length) const {
+    auto page = GetPage(page_num);
+    uint64_t end = (uint64_t)offset + length;
+
+    // the last word starting at or before the offset
+    uint32_t lo = 0, hi = page.num_words;
+    while (lo < hi) {
+      uint32_t mid = lo + (hi - lo) / 2;
+      if (page.GetWord(mid).text_offset <= offset)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+    std::vector<PdfRect> rects;
+    for (uint32_t w = lo ? lo - 1 : 0; w < page.num_words; w++) {
+      auto word = page.GetWord(w);
+      if (word.text_offset >= end)
+        break;
+      uint32_t from = std::max(offset, word.text_offset) - word.text_offset;
+      uint32_t to = (uint32_t)std::min<uint64_t>(end, word.text_offset + word.num_units) -
+        word.text_offset;
+      if (from >= to || word.first_quad + to > page.num_quads)
+        continue;
+      // union of the character boxes of the word
+      QuadRecord q = page.GetQuad(word.first_quad + from);
+      for (uint32_t i = from + 1; i < to; i++) {
+        auto quad = page.GetQuad(word.first_quad + i);
+        q.left = std::min(q.left, quad.left);
+        q.bottom = std::min(q.bottom, quad.bottom);
+        q.right = std::max(q.right, quad.right);
+        q.top = std::max(q.top, quad.top);
+      }
+      PdfRect rect;
+      rect.left = page.left + q.left * page.width / 65535.;
+      rect.right = page.left + q.right * page.width / 65535.;
+      rect.bottom = page.bottom + q.bottom * page.height / 65535.;
+      rect.top = page.bottom + q.top * page.height / 65535.;
+      rects.push_back(rect);
+    }
+    return rects;
+  }
+}
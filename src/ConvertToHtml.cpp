@@ -7,6 +7,10 @@
 
 #include <string>
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <filesystem>
 #include "Pdfix.h"
 #include "PdfToHtml.h"
 
@@ -17,7 +21,9 @@ void ConvertToHtml(
   const std::wstring& save_path,      // output HTML file
   const std::wstring& config_path,    // configuration file
   PdfHtmlParams& html_params,         // conversion parameters
-  const bool preflight                // preflight document template before processing
+  const bool preflight,               // preflight document template before processing
+  HtmlAssetCache* assets,             // shared CSS and JavaScript or nullptr to embed them
+  CancelToken* cancel                 // cancel token or nullptr
 ) {
   // initialize Pdfix
   if (!Pdfix_init(Pdfix_MODULE_NAME))
@@ -67,13 +73,17 @@ void ConvertToHtml(
   if (preflight) {
     // add reference pages for preflight
     for (auto i = 0; i < doc->GetNumPages(); i++) {
-      if (!doc_template->AddPage(i, nullptr, nullptr))
+      if (!doc_template->AddPage(i, &CancelToken::CancelProc, cancel)) {
+        CancelToken::ThrowIfStopped(cancel);
         throw PdfixException();
+      }
     }
       
     // run document preflight
-    if (!doc_template->Update(nullptr, nullptr))
+    if (!doc_template->Update(&CancelToken::CancelProc, cancel)) {
+      CancelToken::ThrowIfStopped(cancel);
       throw PdfixException();
+    }
   }
   /* set html_param
   html_params.type = kPdfHtmlResponsive;
@@ -85,12 +95,41 @@ void ConvertToHtml(
   html_params.flags |= kHtmlNoExternalCSS | kHtmlNoExternalJS | kHtmlNoExternalIMG | kHtmlNoExternalFONT;
   */
 
-  if (!html_doc->Save(save_path.c_str(), &html_params, nullptr, nullptr))
+  if (!html_doc->Save(save_path.c_str(), &html_params, &CancelToken::CancelProc, cancel)) {
+    CancelToken::ThrowIfStopped(cancel);
     throw PdfixException();
+  }
 
   html_doc->Close();
   doc->Close();
 
+  if (assets) {
+    // replace the embedded static CSS and JavaScript, the file is swapped in one step
+    namespace fs = std::filesystem;
+    fs::path path(save_path);
+    std::string html;
+    {
+      std::ifstream file(path, std::ios::binary);
+      if (!file)
+        throw std::runtime_error("HTML file read fail");
+      html.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    if (assets->Externalize(pdf_to_html, html)) {
+      std::stringstream tmp_name;
+      tmp_name << path.filename().string() << "." << std::this_thread::get_id() << ".tmp";
+      auto tmp_path = path.parent_path() / tmp_name.str();
+      {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        file.write(html.data(), html.size());
+        if (!file)
+          throw std::runtime_error("HTML file write fail");
+      }
+      fs::rename(tmp_path, path);
+    }
+    else
+      std::cout << "Static CSS and JavaScript not found in the document HTML" << std::endl;
+  }
+
   pdf_to_html->Destroy();
   pdfix->Destroy();
 }
\ No newline at end of file
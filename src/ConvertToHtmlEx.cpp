@@ -21,7 +21,8 @@ void ConvertToHtmlEx(
   const std::wstring& config_path,    // configuration
   PdfHtmlParams& html_params,         // conversion parameters
   const std::wstring& param1,         // param 1
-  const std::wstring& param2          // param 2
+  const std::wstring& param2,         // param 2
+  CancelToken* cancel                 // cancel token or nullptr
 ) {
   // initialize Pdfix
   if (!Pdfix_init(Pdfix_MODULE_NAME))
@@ -70,16 +71,21 @@ void ConvertToHtmlEx(
       kHtmlNoExternalFONT;
 
     if (param1 == L"document") {
-      if (!html_doc->SaveDocHtml(stm, &html_params, nullptr, nullptr))
+      if (!html_doc->SaveDocHtml(stm, &html_params, &CancelToken::CancelProc, cancel)) {
+        CancelToken::ThrowIfStopped(cancel);
         throw PdfixException();
+      }
     }
     else if (param1 == L"page") {
       auto page_num = atoi(ToUtf8(param2).c_str());
       if (page_num == 0)
         throw std::runtime_error("Invalid page num");
 
-      if (!html_doc->SavePageHtml(stm, &html_params, page_num - 1, nullptr, nullptr))
+      if (!html_doc->SavePageHtml(stm, &html_params, page_num - 1, &CancelToken::CancelProc,
+        cancel)) {
+        CancelToken::ThrowIfStopped(cancel);
         throw PdfixException();
+      }
     }
     html_doc->Close();
     doc->Close();
@@ -0,0 +1,402 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// ConvertToHtmlIncremental.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/ConvertToHtmlIncremental.h"
+
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <memory>
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <unordered_set>
+#include <filesystem>
+#include "pdfixsdksamples/ConvertToHtmlParallel.h"
+#include "pdfixsdksamples/Utils.h"
+#include "Pdfix.h"
+#include "PdfToHtml.h"
+
+using namespace PDFixSDK;
+namespace fs = std::filesystem;
+
+#ifdef GetObject
+#undef GetObject
+#endif
+
+// page attributes inherited from the page tree
+static const wchar_t* kInheritedKeys[] = { L"Resources", L"MediaBox", L"CropBox", L"Rotate" };
+
+// hashes the object graph reachable from the page dictionary
+struct PageHasher {
+  PdsDictionary* page_dict;
+  std::unordered_map<int, uint64_t>& stream_hashes;
+  std::unordered_set<PdsObject*> visited;
+  uint64_t hash = Fnv1aHash(nullptr, 0);
+
+  PageHasher(PdsDictionary* dict, std::unordered_map<int, uint64_t>& hashes)
+    : page_dict(dict), stream_hashes(hashes) {}
+
+  void Add(const void* data, size_t size) { hash = Fnv1aHash(data, size, hash); }
+  void AddInt(int64_t value) { Add(&value, sizeof(value)); }
+  void AddText(const std::wstring& text) {
+    auto str = ToUtf8(text);
+    AddInt((int64_t)str.size());
+    Add(str.data(), str.size());
+  }
+
+  uint64_t HashStreamData(PdsStream* stm) {
+    int id = stm->GetId();
+    if (id > 0) {
+      auto it = stream_hashes.find(id);
+      if (it != stream_hashes.end())
+        return it->second;
+    }
+    // the raw data identify the content together with the filters in the stream dictionary,
+    // decoding is not needed
+    uint64_t data_hash = Fnv1aHash(nullptr, 0);
+    std::vector<unsigned char> buffer(65536);
+    int size = stm->GetRawDataSize();
+    for (int pos = 0; pos < size; pos += (int)buffer.size()) {
+      int read = std::min(size - pos, (int)buffer.size());
+      if (!stm->GetRawData(pos, &buffer[0], read))
+        throw PdfixException();
+      data_hash = Fnv1aHash(&buffer[0], read, data_hash);
+    }
+    if (id > 0)
+      stream_hashes[id] = data_hash;
+    return data_hash;
+  }
+
+  void AddObject(PdsObject* obj) {
+    if (!obj) {
+      AddInt(-1);
+      return;
+    }
+    auto type = obj->GetObjectType();
+    AddInt(type);
+    switch (type) {
+    case kPdsBoolean:
+      AddInt(((PdsBoolean*)obj)->GetValue() ? 1 : 0);
+      break;
+    case kPdsNumber: {
+      PdsNumber* number = (PdsNumber*)obj;
+      if (number->IsIntegerValue())
+        AddInt(number->GetIntegerValue());
+      else {
+        double value = number->GetValue();
+        Add(&value, sizeof(value));
+      }
+    } break;
+    case kPdsName:
+      AddText(((PdsName*)obj)->GetText());
+      break;
+    case kPdsString:
+      AddText(((PdsString*)obj)->GetText());
+      break;
+    case kPdsStream:
+    case kPdsArray:
+    case kPdsDictionary: {
+      // shared objects and cycles are hashed by reference
+      if (!visited.insert(obj).second) {
+        AddInt(obj->GetId());
+        break;
+      }
+      if (type == kPdsStream) {
+        PdsStream* stm = (PdsStream*)obj;
+        AddObject(stm->GetStreamDict());
+        AddInt((int64_t)HashStreamData(stm));
+      }
+      else if (type == kPdsArray) {
+        PdsArray* arr = (PdsArray*)obj;
+        AddInt(arr->GetNumObjects());
+        for (int i = 0; i < arr->GetNumObjects(); i++)
+          AddObject(arr->Get(i));
+      }
+      else
+        AddDictionary((PdsDictionary*)obj);
+    } break;
+    default:
+      break;
+    }
+  }
+
+  void AddDictionary(PdsDictionary* dict) {
+    bool is_page = dict == page_dict;
+    // links and fields point to other pages, those have their own fingerprints
+    if (!is_page) {
+      auto dict_type = dict->GetText(L"Type");
+      if (dict_type == L"Page" || dict_type == L"Pages") {
+        AddInt(dict->GetId());
+        return;
+      }
+    }
+    AddInt(dict->GetNumKeys());
+    for (int i = 0; i < dict->GetNumKeys(); i++) {
+      auto key = dict->GetKey(i);
+      if (is_page && key == L"Parent")
+        continue;
+      AddText(key);
+      AddObject(dict->Get(key.c_str()));
+    }
+  }
+
+  void AddPage() {
+    AddObject(page_dict);
+    for (auto key : kInheritedKeys) {
+      if (page_dict->Get(key))
+        continue;
+      // the nearest ancestor with the attribute, the depth is limited against broken trees
+      PdsDictionary* parent = page_dict->GetDictionary(L"Parent");
+      for (int depth = 0; parent && depth < 64; depth++) {
+        if (auto value = parent->Get(key)) {
+          AddText(key);
+          AddObject(value);
+          break;
+        }
+        parent = parent->GetDictionary(L"Parent");
+      }
+    }
+  }
+};
+
+uint64_t GetPageFingerprint(
+  PdfPage* page,                      // page to fingerprint
+  std::unordered_map<int, uint64_t>& stream_hashes  // stream data hashes by object number
+) {
+  PdsDictionary* page_dict = page->GetObject();
+  if (!page_dict)
+    throw PdfixException();
+  PageHasher hasher(page_dict, stream_hashes);
+  hasher.AddPage();
+  return hasher.hash;
+}
+
+// fingerprints and fragment positions of the previous conversion
+struct HtmlPagesManifest {
+  uint64_t settings = 0;              // hash of everything besides the page the HTML depends on
+  uint64_t html_size = 0;
+  uint64_t html_hash = 0;             // the HTML file is not used when it was changed
+  struct Page {
+    uint64_t fingerprint;
+    uint64_t offset;                  // fragment position in the HTML file
+    uint64_t size;
+  };
+  std::vector<Page> pages;
+};
+
+static uint64_t ParseHex(const std::string& str) {
+  return std::stoull(str, nullptr, 16);
+}
+
+static bool LoadManifest(const fs::path& path, HtmlPagesManifest& manifest) {
+  std::ifstream file(path);
+  std::string header, settings, html_hash;
+  size_t num_pages = 0;
+  if (!std::getline(file, header) || header != "pdfix-html-pages 1")
+    return false;
+  if (!(file >> settings >> manifest.html_size >> html_hash >> num_pages))
+    return false;
+  try {
+    manifest.settings = ParseHex(settings);
+    manifest.html_hash = ParseHex(html_hash);
+    for (size_t i = 0; i < num_pages; i++) {
+      std::string fingerprint;
+      HtmlPagesManifest::Page page;
+      if (!(file >> fingerprint >> page.offset >> page.size))
+        return false;
+      page.fingerprint = ParseHex(fingerprint);
+      manifest.pages.push_back(page);
+    }
+  }
+  catch (std::exception&) {
+    return false;
+  }
+  return true;
+}
+
+static void SaveManifest(const fs::path& path, const HtmlPagesManifest& manifest) {
+  std::stringstream tmp_name;
+  tmp_name << path.filename().string() << "." << std::this_thread::get_id() << ".tmp";
+  auto tmp_path = path.parent_path() / tmp_name.str();
+  {
+    std::ofstream file(tmp_path, std::ios::trunc);
+    file << "pdfix-html-pages 1" << std::endl;
+    file << HashToHex(manifest.settings) << " " << manifest.html_size << " "
+      << HashToHex(manifest.html_hash) << " " << manifest.pages.size() << std::endl;
+    for (auto& page : manifest.pages)
+      file << HashToHex(page.fingerprint) << " " << page.offset << " " << page.size << std::endl;
+    if (!file)
+      throw std::runtime_error("HTML pages manifest write fail");
+  }
+  fs::rename(tmp_path, path);
+}
+
+void ConvertToHtmlIncremental(
+  const std::wstring& open_path,      // source PDF document
+  const std::wstring& save_path,      // output HTML file
+  const std::wstring& config_path,    // configuration file
+  PdfHtmlParams& html_params,         // conversion parameters
+  const bool preflight,               // preflight document template before processing
+  HtmlAssetCache* assets,             // shared CSS and JavaScript or nullptr to embed them
+  CancelToken* cancel                 // cancel token or nullptr
+) {
+  // initialize Pdfix
+  if (!Pdfix_init(Pdfix_MODULE_NAME))
+    throw std::runtime_error("Pdfix initialization fail");
+
+  Pdfix* pdfix = GetPdfix();
+  if (!pdfix)
+    throw std::runtime_error("GetPdfix fail");
+
+  // initialize PdfToHtml
+  if (!PdfToHtml_init(PdfToHtml_MODULE_NAME))
+    throw std::runtime_error("PdfToHtml_init fail");
+
+  auto pdf_to_html = GetPdfToHtml();
+  if (!pdf_to_html)
+    throw std::runtime_error("GetPdfToHtml fail");
+
+  if (!pdf_to_html->Initialize(pdfix))
+    throw PdfixException();
+
+  PdfDoc* doc = pdfix->OpenDoc(open_path.c_str(), L"");
+  if (!doc)
+    throw PdfixException();
+
+  // initialize document template
+  auto doc_template = doc->GetTemplate();
+  if (!doc_template)
+    throw PdfixException();
+
+  if (!config_path.empty()) {
+    PsFileStream* stm = pdfix->CreateFileStream(config_path.c_str(), kPsReadOnly);
+    if (stm) {
+      if (!doc_template->LoadFromStream(stm, kDataFormatJson))
+        throw PdfixException();
+      stm->Destroy();
+    }
+  }
+
+  if (preflight) {
+    for (auto i = 0; i < doc->GetNumPages(); i++) {
+      if (!doc_template->AddPage(i, &CancelToken::CancelProc, cancel)) {
+        CancelToken::ThrowIfStopped(cancel);
+        throw PdfixException();
+      }
+    }
+    if (!doc_template->Update(&CancelToken::CancelProc, cancel)) {
+      CancelToken::ThrowIfStopped(cancel);
+      throw PdfixException();
+    }
+  }
+
+  // fragments are saved to streams, there is no folder for external resources
+  html_params.flags |= kHtmlNoExternalCSS | kHtmlNoExternalJS | kHtmlNoExternalIMG |
+    kHtmlNoExternalFONT;
+
+  // a fragment is reused only when it was made by the same converter with the same settings
+  HtmlPagesManifest manifest;
+  {
+    int settings[] = { pdf_to_html->GetVersionMajor(), pdf_to_html->GetVersionMinor(),
+      pdf_to_html->GetVersionPatch(), html_params.flags, html_params.width, html_params.type,
+      html_params.image.format, html_params.image.quality, preflight ? 1 : 0 };
+    manifest.settings = Fnv1aHash(settings, sizeof(settings));
+    if (!config_path.empty() && fs::exists(config_path)) {
+      auto config_hash = HashFile(config_path);
+      manifest.settings = Fnv1aHash(&config_hash, sizeof(config_hash), manifest.settings);
+    }
+  }
+
+  fs::path html_path(save_path);
+  fs::path manifest_path(save_path + L".pages");
+  HtmlPagesManifest previous;
+  std::ifstream previous_html;
+  bool reuse = false;
+  std::error_code ec;
+  if (LoadManifest(manifest_path, previous) && previous.settings == manifest.settings &&
+    fs::exists(html_path, ec) && fs::file_size(html_path, ec) == previous.html_size &&
+    HashFile(save_path) == previous.html_hash) {
+    previous_html.open(html_path, std::ios::binary);
+    reuse = previous_html.is_open();
+  }
+
+  int num_pages = doc->GetNumPages();
+  std::unordered_map<int, uint64_t> stream_hashes;
+  std::vector<uint64_t> fingerprints(num_pages);
+  auto page_deleter = [](PdfPage* page) { page->Release(); };
+  for (int i = 0; i < num_pages; i++) {
+    CancelToken::ThrowIfStopped(cancel);
+    std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(i), page_deleter);
+    if (!page)
+      throw PdfixException();
+    fingerprints[i] = GetPageFingerprint(page.get(), stream_hashes);
+  }
+
+  auto html_doc_deleter = [](PdfHtmlDoc* html_doc) { html_doc->Close(); };
+  std::unique_ptr<PdfHtmlDoc, decltype(html_doc_deleter)> html_doc(
+    pdf_to_html->OpenHtmlDoc(doc), html_doc_deleter);
+  if (!html_doc)
+    throw PdfixException();
+
+  // the document HTML is small and always saved again
+  auto shell = SaveHtmlShell(html_doc.get(), html_params, cancel);
+  if (assets && !assets->Externalize(pdf_to_html, shell))
+    std::cout << "Static CSS and JavaScript not found in the document HTML" << std::endl;
+  auto pages_pos = GetHtmlPagesPos(shell);
+
+  // write to a temporary file first, the previous HTML file is read while writing
+  std::stringstream tmp_name;
+  tmp_name << html_path.filename().string() << "." << std::this_thread::get_id() << ".tmp";
+  auto tmp_path = html_path.parent_path() / tmp_name.str();
+  int reused = 0;
+  {
+    std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!file)
+      throw std::runtime_error("HTML file write fail");
+    uint64_t offset = 0;
+    manifest.html_hash = Fnv1aHash(nullptr, 0);
+    auto write = [&](const char* data, size_t size) {
+      file.write(data, size);
+      manifest.html_hash = Fnv1aHash(data, size, manifest.html_hash);
+      offset += size;
+    };
+    write(shell.data(), pages_pos);
+
+    for (int i = 0; i < num_pages; i++) {
+      std::string fragment;
+      if (reuse && i < (int)previous.pages.size() &&
+        previous.pages[i].fingerprint == fingerprints[i]) {
+        fragment.resize(previous.pages[i].size);
+        previous_html.seekg(previous.pages[i].offset);
+        if (!fragment.empty() && !previous_html.read(&fragment[0], fragment.size()))
+          throw std::runtime_error("Previous HTML file read fail");
+        reused++;
+      }
+      else
+        fragment = SaveHtmlPage(html_doc.get(), html_params, i, cancel);
+      manifest.pages.push_back({ fingerprints[i], offset, fragment.size() });
+      write(fragment.data(), fragment.size());
+    }
+
+    write(shell.data() + pages_pos, shell.size() - pages_pos);
+    manifest.html_size = offset;
+    if (!file)
+      throw std::runtime_error("HTML file write fail");
+  }
+  previous_html.close();
+  fs::rename(tmp_path, html_path);
+  SaveManifest(manifest_path, manifest);
+
+  std::cout << "HTML pages: " << (num_pages - reused) << " converted, " << reused << " reused"
+    << std::endl;
+
+  html_doc.reset();
+  doc->Close();
+
+  pdf_to_html->Destroy();
+  pdfix->Destroy();
+}
@@ -0,0 +1,250 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// ConvertToHtmlParallel.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/ConvertToHtmlParallel.h"
+
+#include <string>
+#include <iostream>
+#include <memory>
+#include <cstdint>
+#include <vector>
+#include <map>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <exception>
+#include "pdfixsdksamples/OutputSink.h"
+#include "Pdfix.h"
+#include "PdfToHtml.h"
+
+using namespace PDFixSDK;
+
+static std::string ReadMemStream(PsStream* stm) {
+  std::string data(stm->GetSize(), '\0');
+  if (!data.empty() && !stm->Read(0, (uint8_t*)&data[0], (int)data.size()))
+    throw PdfixException();
+  return data;
+}
+
+std::string SaveHtmlShell(
+  PdfHtmlDoc* html_doc,               // HTML document
+  PdfHtmlParams& html_params,         // conversion parameters
+  CancelToken* cancel                 // cancel token or nullptr
+) {
+  auto stm_deleter = [](PsStream* stm) { stm->Destroy(); };
+  std::unique_ptr<PsStream, decltype(stm_deleter)> stm(GetPdfix()->CreateMemStream(),
+    stm_deleter);
+  if (!stm)
+    throw PdfixException();
+  if (!html_doc->SaveDocHtml(stm.get(), &html_params, &CancelToken::CancelProc, cancel)) {
+    CancelToken::ThrowIfStopped(cancel);
+    throw PdfixException();
+  }
+  return ReadMemStream(stm.get());
+}
+
+std::string SaveHtmlPage(
+  PdfHtmlDoc* html_doc,               // HTML document
+  PdfHtmlParams& html_params,         // conversion parameters
+  int page_num,                       // page number
+  CancelToken* cancel                 // cancel token or nullptr
+) {
+  auto stm_deleter = [](PsStream* stm) { stm->Destroy(); };
+  std::unique_ptr<PsStream, decltype(stm_deleter)> stm(GetPdfix()->CreateMemStream(),
+    stm_deleter);
+  if (!stm)
+    throw PdfixException();
+  if (!html_doc->SavePageHtml(stm.get(), &html_params, page_num, &CancelToken::CancelProc,
+    cancel)) {
+    CancelToken::ThrowIfStopped(cancel);
+    throw PdfixException();
+  }
+  return ReadMemStream(stm.get());
+}
+
+size_t GetHtmlPagesPos(const std::string& shell) {
+  auto pos = shell.rfind("</body>");
+  if (pos == std::string::npos)
+    pos = shell.rfind("</BODY>");
+  return pos == std::string::npos ? shell.size() : pos;
+}
+
+void ConvertToHtmlParallel(
+  const std::wstring& open_path,      // source PDF document
+  const std::wstring& save_path,      // output HTML file
+  const std::wstring& config_path,    // configuration file
+  PdfHtmlParams& html_params,         // conversion parameters
+  const bool preflight,               // preflight document template before processing
+  const size_t thread_count,          // number of conversion workers
+  HtmlAssetCache* assets,             // shared CSS and JavaScript or nullptr to embed them
+  CancelToken* cancel                 // cancel token or nullptr
+) {
+  // initialize Pdfix
+  if (!Pdfix_init(Pdfix_MODULE_NAME))
+    throw std::runtime_error("Pdfix initialization fail");
+
+  Pdfix* pdfix = GetPdfix();
+  if (!pdfix)
+    throw std::runtime_error("GetPdfix fail");
+
+  // initialize PdfToHtml
+  if (!PdfToHtml_init(PdfToHtml_MODULE_NAME))
+    throw std::runtime_error("PdfToHtml_init fail");
+
+  auto pdf_to_html = GetPdfToHtml();
+  if (!pdf_to_html)
+    throw std::runtime_error("GetPdfToHtml fail");
+
+  if (!pdf_to_html->Initialize(pdfix))
+    throw PdfixException();
+
+  PdfDoc* doc = pdfix->OpenDoc(open_path.c_str(), L"");
+  if (!doc)
+    throw PdfixException();
+
+  // initialize document template, it's shared by all workers
+  auto doc_template = doc->GetTemplate();
+  if (!doc_template)
+    throw PdfixException();
+
+  if (!config_path.empty()) {
+    PsFileStream* stm = pdfix->CreateFileStream(config_path.c_str(), kPsReadOnly);
+    if (stm) {
+      if (!doc_template->LoadFromStream(stm, kDataFormatJson))
+        throw PdfixException();
+      stm->Destroy();
+    }
+  }
+
+  if (preflight) {
+    for (auto i = 0; i < doc->GetNumPages(); i++) {
+      if (!doc_template->AddPage(i, &CancelToken::CancelProc, cancel)) {
+        CancelToken::ThrowIfStopped(cancel);
+        throw PdfixException();
+      }
+    }
+    if (!doc_template->Update(&CancelToken::CancelProc, cancel)) {
+      CancelToken::ThrowIfStopped(cancel);
+      throw PdfixException();
+    }
+  }
+
+  // fragments are saved to streams, there is no folder for external resources
+  html_params.flags |= kHtmlNoExternalCSS | kHtmlNoExternalJS | kHtmlNoExternalIMG |
+    kHtmlNoExternalFONT;
+
+  auto html_doc_deleter = [](PdfHtmlDoc* html_doc) { html_doc->Close(); };
+  std::string shell;
+  {
+    std::unique_ptr<PdfHtmlDoc, decltype(html_doc_deleter)> html_doc(
+      pdf_to_html->OpenHtmlDoc(doc), html_doc_deleter);
+    if (!html_doc)
+      throw PdfixException();
+    shell = SaveHtmlShell(html_doc.get(), html_params, cancel);
+  }
+  if (assets && !assets->Externalize(pdf_to_html, shell))
+    std::cout << "Static CSS and JavaScript not found in the document HTML" << std::endl;
+  auto pages_pos = GetHtmlPagesPos(shell);
+
+  // a .gz output is compressed on the sink thread while the pages are converted
+  OutputSink file(save_path, GetOutputCompression(save_path));
+  auto write = [&](const char* data, size_t size) {
+    if (!file.write(data, size)) {
+      // throws the error of the sink thread
+      file.Close();
+      throw std::runtime_error("HTML file write fail");
+    }
+  };
+  write(shell.data(), pages_pos);
+
+  int num_pages = doc->GetNumPages();
+  size_t workers_count = std::max<size_t>(thread_count, 1);
+  // pages converted ahead of the writer
+  int window = (int)workers_count * 4;
+  std::atomic<int> next_page(0);
+  int written = 0;
+  std::map<int, std::string> fragments;
+  std::exception_ptr error;
+  std::mutex mutex;                   // guards written, fragments and error
+  std::condition_variable page_done, page_written;
+
+  auto worker = [&]() {
+    try {
+      std::unique_ptr<PdfHtmlDoc, decltype(html_doc_deleter)> html_doc(
+        pdf_to_html->OpenHtmlDoc(doc), html_doc_deleter);
+      if (!html_doc)
+        throw PdfixException();
+      PdfHtmlParams params = html_params;
+
+      for (int i = next_page++; i < num_pages; i = next_page++) {
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          page_written.wait(lock, [&]() { return error || i < written + window; });
+          if (error)
+            return;
+        }
+        auto fragment = SaveHtmlPage(html_doc.get(), params, i, cancel);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        fragments[i] = std::move(fragment);
+        page_done.notify_all();
+      }
+    }
+    catch (...) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!error)
+        error = std::current_exception();
+      // stop the other workers and the writer
+      next_page = num_pages;
+      page_done.notify_all();
+      page_written.notify_all();
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < workers_count; i++)
+    workers.emplace_back(worker);
+
+  // write the fragments in page order on this thread
+  try {
+    for (int i = 0; i < num_pages; i++) {
+      std::string fragment;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        page_done.wait(lock, [&]() { return error || fragments.count(i) != 0; });
+        if (error)
+          break;
+        fragment = std::move(fragments[i]);
+        fragments.erase(i);
+      }
+      write(fragment.data(), fragment.size());
+
+      std::lock_guard<std::mutex> lock(mutex);
+      written = i + 1;
+      page_written.notify_all();
+    }
+  }
+  catch (...) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!error)
+      error = std::current_exception();
+    next_page = num_pages;
+    page_written.notify_all();
+  }
+  for (auto& w : workers)
+    w.join();
+  if (error)
+    std::rethrow_exception(error);
+
+  write(shell.data() + pages_pos, shell.size() - pages_pos);
+  file.Close();
+
+  doc->Close();
+
+  pdf_to_html->Destroy();
+  pdfix->Destroy();
+}
@@ -7,22 +7,30 @@
 
 #include <string>
 #include <iostream>
+#include <thread>
+#include <algorithm>
 #include "Pdfix.h"
 
 using namespace PDFixSDK;
 
-// SaveImage processes each element recursively. If the element is an image, it saves it to save_path.
+// SaveImage processes each element recursively. If the element is an image, it renders it and hands
+// it over to the pipeline which encodes and saves it to save_path.
 void SaveImage(PdeElement* element, 
   const std::wstring& save_path, 
-  PdfImageParams& img_params,
+  ImagePipeline& pipeline,
   PdfPage* page, 
   PdfPageView* page_view, 
-  int& image_index) {
+  int& image_index,
+  CancelToken* cancel) {
 
   Pdfix* pdfix = GetPdfix();
     
   PdfElementType elem_type = element->GetType();
     
+  // the pipeline drops the images after an error, Finish rethrows it
+  if (pipeline.HasError())
+    return;
+
   if (elem_type == kPdeImage) {
     PdeImage* image = static_cast<PdeImage*>(element);
       
@@ -44,11 +52,15 @@ void SaveImage(PdeElement* element,
     PdfPageRenderParams render_params;
     render_params.image = ps_image;
     page_view->GetDeviceMatrix(&render_params.matrix);
-    page->DrawContent(&render_params, nullptr, nullptr);
+    if (!page->DrawContent(&render_params, &CancelToken::CancelProc, cancel)) {
+      ps_image->Destroy();
+      CancelToken::ThrowIfStopped(cancel);
+      throw PdfixException();
+    }
       
     std::wstring path = save_path + L"/ExtractImages_" + std::to_wstring(image_index++) + L".png";
-    ps_image->SaveRect(path.c_str(), &img_params, &elem_dev_rect);
-    ps_image->Destroy();
+    // the pipeline owns the image from now on
+    pipeline.Push(ps_image, &elem_dev_rect, path);
 
     image->SetRender(false);
   }
@@ -59,7 +71,7 @@ void SaveImage(PdeElement* element,
   for (int i = 0; i < count; i++) {
     PdeElement* child = element->GetChild(i);
     if (child)
-      SaveImage(child, save_path, img_params, page, page_view, image_index);
+      SaveImage(child, save_path, pipeline, page, page_view, image_index, cancel);
   }
 }
 
@@ -68,7 +80,8 @@ void ExtractImages(
   const std::wstring& open_path,                // source PDF document
   const std::wstring& save_path,                // directory where to extract images
   int render_width,                             // with of the rendered page in pixels (image )
-  PdfImageParams& img_params                    // image parameters
+  PdfImageParams& img_params,                   // image parameters
+  CancelToken* cancel                           // cancel token or nullptr
 ) {
   // initialize Pdfix
   if (!Pdfix_init(Pdfix_MODULE_NAME))
@@ -88,9 +101,13 @@ void ExtractImages(
   img_params.format = kImageFormatPng;
   int image_index = 1;
 
+  // encode and write images on background threads while the next image is rendered
+  size_t encode_threads = std::max(2u, std::thread::hardware_concurrency()) - 1;
+  ImagePipeline pipeline(img_params, encode_threads, 2 * encode_threads);
+
   auto num_pages = doc->GetNumPages();
 
-  for (auto i = 0; i < num_pages; i++) {
+  for (auto i = 0; i < num_pages && !pipeline.HasError(); i++) {
     std::cout << std::endl;
     std::cout << "Processing pages..." << i + 1 << "/" << num_pages;
 
@@ -106,17 +123,22 @@ void ExtractImages(
     if (!page_view)
       throw PdfixException();
 
-    PdePageMap* page_map = page->AcquirePageMap(nullptr, nullptr);
-    if (!page_map)
+    PdePageMap* page_map = page->AcquirePageMap(&CancelToken::CancelProc, cancel);
+    if (!page_map) {
+      CancelToken::ThrowIfStopped(cancel);
       throw PdfixException();
+    }
 
     auto element = page_map->GetElement();
     if (!element)
       throw PdfixException();
-    SaveImage(element, save_path.c_str(), img_params, page, page_view, image_index);
+    SaveImage(element, save_path.c_str(), pipeline, page, page_view, image_index, cancel);
 
+    page_map->Release();
+    page_view->Release();
     page->Release();
   }
+  pipeline.Finish();
   std::cout << std::endl << image_index - 1 << " images found" << std::endl;
 
   doc->Close();
@@ -4,18 +4,22 @@
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "pdfixsdksamples/ExtractData.h"
+#include "pdfixsdksamples/Utils.h"
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
 
 namespace ExtractData {
   // extract text page object data
-  void ExtractTextObject(PdsText *text, ptree &node, const DataType &data_types) {
+  void ExtractTextObject(PdsText *text, ptree &node, const DataType &data_types,
+    DocState &state) {
     node.put("text", EncodeText(text->GetText()));
 
     if (data_types.text_state) {
-      // ptree text_state_node;
-      // PdfTextState ts;
-      // text->GetTextState(doc, &ts);
-      // ExtractTextState(&ts, text_state_node, data_types);
-      // node.put_child("text_state", text_state_node);
+      PdfTextState ts;
+      if (text->GetTextState(text->GetPage()->GetDoc(), &ts))
+        node.put("style", InternTextState(&ts, data_types, state));
     }
   }
 
@@ -30,8 +34,37 @@ namespace ExtractData {
     image->SetRender(false);
   }
 
-  // extract form page object data
-  void ExtractFormObject(PdsForm *form, ptree &node, const DataType &data_types) {
+  // extract form page object data, the content of a Form XObject drawn more times is extracted
+  // only once, in the page space of its first use. Later uses refer to it by the xobject id, their
+  // ref_matrix maps the extracted content to the page space of the use.
+  void ExtractFormObject(PdsForm *form, ptree &node, const DataType &data_types,
+    DocState &state) {
+    PdfMatrix matrix;
+    if (form->GetMatrix(&matrix)) {
+      ptree matrix_node;
+      ExtractMatrix(matrix, matrix_node, data_types);
+      node.put_child("matrix", matrix_node);
+    }
+
+    auto xobject = form->GetObject();
+    int id = xobject ? xobject->GetId() : 0;
+    if (id > 0) {
+      node.put("xobject", id);
+      auto first = state.forms.find(id);
+      PdfMatrix ref_matrix;
+      // a first use with a singular matrix gives no page space to map from, the content is
+      // extracted again
+      if (first != state.forms.end() && PdfMatrixInverse(first->second, ref_matrix)) {
+        PdfMatrixConcat(ref_matrix, matrix, false);
+        ptree matrix_node;
+        ExtractMatrix(ref_matrix, matrix_node, data_types);
+        node.put("ref", true);
+        node.put_child("ref_matrix", matrix_node);
+        return;
+      }
+      state.forms[id] = matrix;
+    }
+
     auto page_content_deleter = [&](PdsContent* content) { content->Release(); };
     std::unique_ptr<PdsContent, decltype(page_content_deleter)> 
       content(form->AcquireContent(), page_content_deleter);  
@@ -39,17 +72,114 @@ namespace ExtractData {
       throw PdfixException();
 
     ptree content_node;
-    ExtractPageContent(content.get(), content_node, data_types);
+    ExtractPageContent(content.get(), content_node, data_types, state);
     node.put_child("content", content_node);
   }
 
-  // extract path page object data
+  // Douglas-Peucker simplification of the polyline points[first..last], marks the points to keep
+  static void SimplifyPolyline(const std::vector<PdfPoint>& points, size_t first, size_t last,
+    double tolerance, std::vector<bool>& keep) {
+    std::vector<std::pair<size_t, size_t>> ranges = { { first, last } };
+    while (!ranges.empty()) {
+      auto range = ranges.back();
+      ranges.pop_back();
+      auto& a = points[range.first];
+      auto& b = points[range.second];
+      keep[range.first] = keep[range.second] = true;
+      double dx = b.x - a.x, dy = b.y - a.y;
+      double length = std::hypot(dx, dy);
+      double max_dist = 0;
+      size_t index = range.first;
+      for (size_t i = range.first + 1; i < range.second; i++) {
+        auto& p = points[i];
+        double dist = length > 0 ? std::fabs(dy * (p.x - a.x) - dx * (p.y - a.y)) / length :
+          std::hypot(p.x - a.x, p.y - a.y);
+        if (dist > max_dist) {
+          max_dist = dist;
+          index = i;
+        }
+      }
+      if (max_dist > tolerance) {
+        ranges.push_back(std::make_pair(range.first, index));
+        ranges.push_back(std::make_pair(index, range.second));
+      }
+    }
+  }
+
+  // extract path page object data, the operators are written as a string with one letter per
+  // point: m move, l line, c bezier (3 points per segment) and h after the point closing the
+  // subpath. The coordinates are quantised to path_precision and each one is written as the
+  // difference from the previous point, e.g. "m 10 20 l 5 0" is ops "ml" and coords "10 20 5 0".
   void ExtractPathObject(PdsPath *path, ptree &node, const DataType &data_types) {
-    // ...
+    // paths outside of the page are never visible
+    if (data_types.path_cull) {
+      auto bbox = path->GetBBox();
+      auto crop_box = path->GetPage()->GetCropBox();
+      if (bbox.right < crop_box.left || bbox.left > crop_box.right ||
+        bbox.top < crop_box.bottom || bbox.bottom > crop_box.top)
+        return;
+    }
+
+    int num_points = path->GetNumPathPoints();
+    std::vector<PdfPoint> points(num_points);
+    std::vector<PdfPathPointType> types(num_points);
+    std::vector<bool> closed(num_points);
+    for (int i = 0; i < num_points; i++) {
+      auto path_point = path->GetPathPoint(i);
+      if (!path_point)
+        throw PdfixException();
+      types[i] = path_point->GetType();
+      path_point->GetPoint(&points[i]);
+      closed[i] = path_point->IsClosed();
+    }
+
+    // only the runs of line points are simplified, bezier control points are kept
+    std::vector<bool> keep(num_points, true);
+    if (data_types.path_tolerance > 0) {
+      for (int i = 0; i < num_points; ) {
+        int last = i;
+        while (last + 1 < num_points && types[last + 1] == kPathLineTo && !closed[last])
+          last++;
+        if (last - i > 1) {
+          std::fill(keep.begin() + i, keep.begin() + last + 1, false);
+          SimplifyPolyline(points, i, last, data_types.path_tolerance, keep);
+        }
+        i = last + 1;
+      }
+    }
+
+    std::string ops;
+    std::stringstream coords;
+    long long x = 0, y = 0;
+    for (int i = 0; i < num_points; i++) {
+      if (!keep[i])
+        continue;
+      switch (types[i]) {
+        case kPathMoveTo: ops += 'm'; break;
+        case kPathBezierTo: ops += 'c'; break;
+        default: ops += 'l';
+      }
+      if (closed[i])
+        ops += 'h';
+      auto qx = std::llround(points[i].x / data_types.path_precision);
+      auto qy = std::llround(points[i].y / data_types.path_precision);
+      if (coords.tellp() > 0)
+        coords << " ";
+      coords << (qx - x) << " " << (qy - y);
+      x = qx;
+      y = qy;
+    }
+
+    ptree path_node;
+    path_node.put("precision", data_types.path_precision);
+    path_node.put("ops", ops);
+    path_node.put("coords", coords.str());
+    node.put_child("path", path_node);
   }
 
   // extract page object data
-  void ExtractPageObject(PdsPageObject *object, ptree &node, const DataType &data_types) {
+  void ExtractPageObject(PdsPageObject *object, ptree &node, const DataType &data_types,
+    DocState &state) {
     // general information
     auto get_object_type_string = [&]() {
       switch (object->GetObjectType()) {
@@ -72,10 +202,10 @@ namespace ExtractData {
     switch (object->GetObjectType()) {
       case kPdsPageText: 
         if (data_types.extract_text)
-          ExtractTextObject((PdsText *)object, node, data_types);
+          ExtractTextObject((PdsText *)object, node, data_types, state);
         break;
       case kPdsPageForm: 
-        ExtractFormObject((PdsForm *)object, node, data_types);
+        ExtractFormObject((PdsForm *)object, node, data_types, state);
         break;
       case kPdsPagePath: 
         if (data_types.extract_paths)
@@ -90,11 +220,12 @@ namespace ExtractData {
   }
 
   // extract data from a PdsContnet object
-  void ExtractPageContent(PdsContent *content, ptree &node, const DataType &data_types) {
+  void ExtractPageContent(PdsContent *content, ptree &node, const DataType &data_types,
+    DocState &state) {
     ptree objects_node;
     for (int i = 0; i < content->GetNumObjects(); i++) {
       ptree object_node;
-      ExtractPageObject(content->GetObject(i), object_node, data_types);
+      ExtractPageObject(content->GetObject(i), object_node, data_types, state);
       objects_node.push_back(std::make_pair("", object_node));
     }
     node.put_child("kids", objects_node);
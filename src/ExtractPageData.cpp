@@ -22,27 +22,31 @@ namespace ExtractData {
       node.put_child("annots", annots_node);
   }
 
-  void ExtractPageMapData(PdfPage *page, ptree &node, const DataType &data_types) {
+  void ExtractPageMapData(PdfPage *page, ptree &node, const DataType &data_types,
+    DocState &state) {
     auto page_map_deleter = [&](PdePageMap* page_map) { page_map->Release(); };
     std::unique_ptr<PdePageMap, decltype(page_map_deleter)> 
-      page_map(page->AcquirePageMap(nullptr, nullptr), page_map_deleter);  
-    if (!page_map)
+      page_map(page->AcquirePageMap(&CancelToken::CancelProc, state.cancel), page_map_deleter);
+    if (!page_map) {
+      CancelToken::ThrowIfStopped(state.cancel);
       throw PdfixException();
+    }
 
     ptree page_map_node;
 
     ptree bbox_node;
-    ExtractPageMap(page_map.get(), page_map_node, data_types);
+    ExtractPageMap(page_map.get(), page_map_node, data_types, state);
     page_map_node.put_child("bbox", bbox_node);
 
     node.put_child("content", page_map_node);
   }
 
-  void ExtractPageContentData(PdfPage* page, ptree &node, const DataType &data_types) {    
+  void ExtractPageContentData(PdfPage* page, ptree &node, const DataType &data_types,
+    DocState &state) {
     auto content = page->GetContent();
 
     ptree contnet_node;
-    ExtractPageContent(content, contnet_node, data_types);
+    ExtractPageContent(content, contnet_node, data_types, state);
     node.put_child("content", contnet_node);
   }
 
@@ -56,7 +60,8 @@ namespace ExtractData {
   }
 
   // save page data
-  void ExtractPageData(PdfPage* page, ptree& node, const DataType& data_types) {
+  void ExtractPageData(PdfPage* page, ptree& node, const DataType& data_types,
+    DocState& state) {
     if (data_types.page_info)
       ExtractPageInfo(page, node, data_types);
 
@@ -64,9 +69,9 @@ namespace ExtractData {
       ExtractPageAnnots(page, node, data_types);
 
     if (data_types.page_map) 
-      ExtractPageMapData(page, node, data_types);
+      ExtractPageMapData(page, node, data_types, state);
 
     if (data_types.page_content) 
-      ExtractPageContentData(page, node, data_types);
+      ExtractPageContentData(page, node, data_types, state);
   }
 }
\ No newline at end of file
@@ -7,20 +7,20 @@
 
 namespace ExtractData {
   // extract text element
-  void ExtractTextElement(PdeText* text, ptree& node, const DataType& data_types) {
+  void ExtractTextElement(PdeText* text, ptree& node, const DataType& data_types,
+    DocState& state) {
     node.put("text", EncodeText(text->GetText()));
 
     if (data_types.text_state) {
-      ptree text_state_node;
       PdfTextState ts;
-      text->GetTextState(&ts);
-      ExtractTextState(&ts, text_state_node, data_types);
-      node.put_child("text_state", text_state_node);
+      if (text->GetTextState(&ts))
+        node.put("style", InternTextState(&ts, data_types, state));
     }
   }
 
   // extract table element
-  void ExtractTableElement(PdeTable* table, ptree& node, const DataType& data_types) {
+  void ExtractTableElement(PdeTable* table, ptree& node, const DataType& data_types,
+    DocState& state) {
     node.put("num_colls", table->GetNumCols());
     node.put("num_rows", table->GetNumRows());
 
@@ -32,7 +32,7 @@ namespace ExtractData {
         if (!cell)
           throw PdfixException();
         ptree cell_node;
-        ExtractPageElement(cell, cell_node, data_types);
+        ExtractPageElement(cell, cell_node, data_types, state);
         cols_node.push_back(std::make_pair("", cell_node));
       }
       rows_node.push_back(std::make_pair("", cols_node));
@@ -52,7 +52,8 @@ namespace ExtractData {
   }
 
   // write page element
-  void ExtractPageElement(PdeElement* element, ptree& node, const DataType& data_types) {
+  void ExtractPageElement(PdeElement* element, ptree& node, const DataType& data_types,
+    DocState& state) {
     auto get_element_type_string = [&]() {
       std::string type = "unknown";
       switch (element->GetType()) {
@@ -86,11 +87,11 @@ namespace ExtractData {
     switch (element->GetType()) {
       case kPdeText: 
         if (data_types.extract_text) 
-          ExtractTextElement((PdeText *)element, node, data_types);
+          ExtractTextElement((PdeText *)element, node, data_types, state);
         break;
       case kPdeTable:
         if (data_types.extract_tables)
-          ExtractTableElement((PdeTable *)element, node, data_types);
+          ExtractTableElement((PdeTable *)element, node, data_types, state);
         break;
       case kPdeImage:
         if (data_types.extract_images)
@@ -103,7 +104,7 @@ namespace ExtractData {
     ptree kids_node;
     for (int i = 0; i < element->GetNumChildren(); i++) {
       ptree kid_node;
-      ExtractPageElement(element->GetChild(i), kid_node, data_types);
+      ExtractPageElement(element->GetChild(i), kid_node, data_types, state);
       kids_node.push_back(std::make_pair("", kid_node));
     }
     if (kids_node.size())
@@ -111,13 +112,14 @@ namespace ExtractData {
   }
 
   // process page map
-  void ExtractPageMap(PdePageMap* page_map, ptree& node, const DataType& data_types) {
+  void ExtractPageMap(PdePageMap* page_map, ptree& node, const DataType& data_types,
+    DocState& state) {
     auto element = page_map->GetElement();
     if (!element)
       throw PdfixException();
 
     ptree element_node;
-    ExtractPageElement(element, element_node, data_types);
+    ExtractPageElement(element, element_node, data_types, state);
     node.put_child("elements", element_node);
   }
 }
\ No newline at end of file
@@ -13,13 +13,17 @@
 namespace ExtractData {
 
   // extract page-based data
-  void ExtractDocumentPages(PdfDoc* doc, ptree& node, const DataType& data_types) {
+  void ExtractDocumentPages(PdfDoc* doc, ptree& node, const DataType& data_types,
+    CancelToken* cancel) {
     ptree pages_node; // node holding the page array
+    DocState state;   // shared by the pages
+    state.cancel = cancel;
 
     auto from_page = data_types.page_num == -1 ? 0 : data_types.page_num; 
     auto to_page = data_types.page_num == -1 ? doc->GetNumPages() - 1 : data_types.page_num; 
 
     for (auto i = from_page; i <= to_page; i++) {  
+      CancelToken::ThrowIfStopped(cancel);
       auto page_deleter = [&](PdfPage *page) { page->Release(); };
       auto page = std::unique_ptr<PdfPage, 
             decltype(page_deleter)>(doc->AcquirePage(i), page_deleter);
@@ -27,12 +31,14 @@ namespace ExtractData {
         throw PdfixException();
       
       ptree page_node; // node holding the page
-      ExtractPageData(page.get(), page_node, data_types);
+      ExtractPageData(page.get(), page_node, data_types, state);
       if (page_node.size())
         pages_node.push_back(std::make_pair("", page_node));
     }
     if (pages_node.size())
       node.add_child("pages", pages_node);
+    if (state.styles.size())
+      node.add_child("styles", state.styles);
   }
 
   // extract general document information (metadata, page count, is tagged, is form)
@@ -45,7 +51,8 @@ namespace ExtractData {
   }
 
   // save document information
-  void ExtractDocumentData(PdfDoc* doc, ptree& node, const DataType& data_types) {
+  void ExtractDocumentData(PdfDoc* doc, ptree& node, const DataType& data_types,
+    CancelToken* cancel) {
 
     if (data_types.doc_info)
       ExtractDocumentInfo(doc, node, data_types);
@@ -57,7 +64,7 @@ namespace ExtractData {
     //   ExtractDocumentAcroForm(doc, ptree & node, data_types);
 
     // pages
-    ExtractDocumentPages(doc, node, data_types);
+    ExtractDocumentPages(doc, node, data_types, cancel);
   }
 
   ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -67,7 +74,8 @@ namespace ExtractData {
     std::ostream &output,
     const DataType &data_types,
     bool preflight,
-    PsDataFormat format)
+    PsDataFormat format,
+    CancelToken* cancel)
   {
     // initialize Pdfix
     if (!Pdfix_init(Pdfix_MODULE_NAME))
@@ -97,17 +105,21 @@ namespace ExtractData {
     if (preflight) {
       // add reference pages for preflight
       for (auto i = 0; i < doc->GetNumPages(); i++) {
-        if (!doc_template->AddPage(i, nullptr, nullptr))
+        if (!doc_template->AddPage(i, &CancelToken::CancelProc, cancel)) {
+          CancelToken::ThrowIfStopped(cancel);
           throw PdfixException();
+        }
       }
         
       // run document preflight
-      if (!doc_template->Update(nullptr, nullptr))
+      if (!doc_template->Update(&CancelToken::CancelProc, cancel)) {
+        CancelToken::ThrowIfStopped(cancel);
         throw PdfixException();
+      }
     }
 
     ptree doc_node;   // node holding the document
-    ExtractDocumentData(doc, doc_node, data_types);
+    ExtractDocumentData(doc, doc_node, data_types, cancel);
 
     doc->Close();
 
@@ -7,6 +7,8 @@
 
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/property_tree/xml_parser.hpp>
+#include <cmath>
+#include <cstdio>
 // project
 #include "Pdfix.h"
 
@@ -26,9 +28,45 @@ namespace ExtractData {
     node.push_back(std::make_pair("", top_node));
   }
 
+  void ExtractMatrix(PdfMatrix matrix, ptree& node, const DataType& data_types) {
+    for (double value : { matrix.a, matrix.b, matrix.c, matrix.d, matrix.e, matrix.f }) {
+      ptree value_node;
+      value_node.put("", value);
+      node.push_back(std::make_pair("", value_node));
+    }
+  }
 
   void ExtractTextState(PdfTextState *text_state, ptree &node, const DataType &data_types) {
-    // todo
+    auto color_to_hex = [](const PdfRGB& color) {
+      char hex[8];
+      snprintf(hex, sizeof(hex), "#%02x%02x%02x", color.r & 0xff, color.g & 0xff, color.b & 0xff);
+      return std::string(hex);
+    };
+    // rounded, so nearly identical states share one style
+    auto round = [](double value) { return std::round(value * 100) / 100; };
+
+    node.put("font_name", text_state->font ? EncodeText(text_state->font->GetFontName()) : "");
+    node.put("font_size", round(text_state->font_size));
+    node.put("fill_color", color_to_hex(text_state->color_state.fill_color));
+    node.put("stroke_color", color_to_hex(text_state->color_state.stroke_color));
+    node.put("fill_opacity", text_state->color_state.fill_opacity);
+    node.put("char_spacing", round(text_state->char_spacing));
+    node.put("word_spacing", round(text_state->word_spacing));
+    node.put("flags", (int)text_state->flags);
+  }
+
+  int InternTextState(PdfTextState *text_state, const DataType &data_types, DocState &state) {
+    ptree style_node;
+    ExtractTextState(text_state, style_node, data_types);
+    std::stringstream key;
+    write_json(key, style_node, false);
+    auto it = state.style_ids.find(key.str());
+    if (it != state.style_ids.end())
+      return it->second;
+    int style_id = (int)state.styles.size();
+    state.styles.push_back(std::make_pair("", style_node));
+    state.style_ids[key.str()] = style_id;
+    return style_id;
   }
 
   // render page are into an image
@@ -9,13 +9,14 @@
 #include <iostream>
 #include <fstream>
 #include "pdfixsdksamples/Utils.h"
+#include "pdfixsdksamples/OutputSink.h"
 #include "Pdfix.h"
 
 using namespace PDFixSDK;
 
 // Example how to extract tables from a PDF document and save them to csv format.
 // GetText processes each element recursively. If the element is a text, saves it to the output stream.
-void GetText(PdeText* element, std::ofstream& ofs, bool eof) {
+void GetText(PdeText* element, std::ostream& ofs, bool eof) {
   PdeText* text_elem = static_cast<PdeText*>(element);
   std::wstring text = text_elem->GetText();
 
@@ -27,16 +28,17 @@ void GetText(PdeText* element, std::ofstream& ofs, bool eof) {
 
 // SaveTable processes each element recursively. 
 // If the element is a table, it saves it to save_path as csv.
-void SaveTable(PdeElement* element, std::wstring save_path, int& table_index) {
+void SaveTable(PdeElement* element, std::wstring save_path, int& table_index,
+  OutputCompression compression) {
   Pdfix* pdfix = GetPdfix();
 
   PdfElementType elem_type = element->GetType();
   if (elem_type == kPdeTable) {
     PdeTable* table = static_cast<PdeTable*>(element);
 
-    auto path = save_path + L"/ExtractTables_" + std::to_wstring(table_index++) + L".csv";
-    std::ofstream ofs;
-    ofs.open(ToUtf8(path));
+    auto path = save_path + L"/ExtractTables_" + std::to_wstring(table_index++) +
+      (compression == kOutputGzip ? L".csv.gz" : L".csv");
+    OutputSink ofs(path, compression);
 
     int row_count = table->GetNumRows();
     int col_count = table->GetNumCols();
@@ -72,7 +74,7 @@ void SaveTable(PdeElement* element, std::wstring save_path, int& table_index) {
         ofs << std::endl;
     }
 
-    ofs.close();
+    ofs.Close();
   }
   else {
     int count = element->GetNumChildren();
@@ -81,7 +83,7 @@ void SaveTable(PdeElement* element, std::wstring save_path, int& table_index) {
     for (int i = 0; i < count; i++) {
       PdeElement* child = element->GetChild(i);
       if (child)
-        SaveTable(child, save_path, table_index);
+        SaveTable(child, save_path, table_index, compression);
     }
   }
 }
@@ -89,7 +91,9 @@ void SaveTable(PdeElement* element, std::wstring save_path, int& table_index) {
 // Extracts all tables from the document and saves them to CSV format. 
 void ExtractTables(
   const std::wstring& open_path,                 // source PDF document
-  const std::wstring& save_path                  // directory where to extract images
+  const std::wstring& save_path,                 // directory where to extract images
+  OutputCompression compression,                 // CSV files compression
+  CancelToken* cancel                            // cancel token or nullptr
 ) {
   // initialize Pdfix
   if (!Pdfix_init(Pdfix_MODULE_NAME))
@@ -110,15 +114,17 @@ void ExtractTables(
     PdfPage* page = doc->AcquirePage(i);
     if (!page)
       throw PdfixException();
-    PdePageMap* page_map = page->AcquirePageMap(nullptr, nullptr);
-    if (!page_map)
+    PdePageMap* page_map = page->AcquirePageMap(&CancelToken::CancelProc, cancel);
+    if (!page_map) {
+      CancelToken::ThrowIfStopped(cancel);
       throw PdfixException();
+    }
 
     auto element = page_map->GetElement();
     if (!element)
       throw PdfixException();
 
-    SaveTable(element, save_path, table_index);
+    SaveTable(element, save_path, table_index, compression);
 
     page->Release();
   }
@@ -10,6 +10,7 @@
 #include <sstream>
 #include <memory>
 #include <algorithm>
+#include "pdfixsdksamples/CharIndex.h"
 #include "Pdfix.h"
 
 using namespace PDFixSDK;
@@ -45,11 +46,13 @@ namespace ExtractText {
     }
   }
 
-  void GetPageText(PdfPage* page, std::stringstream &ss){
-    std::unique_ptr<PdePageMap, decltype(page_map_deleter)> page_map(page->AcquirePageMap(nullptr, nullptr),
-      page_map_deleter);
-    if (!page_map)
+  void GetPageText(PdfPage* page, std::stringstream &ss, CancelToken* cancel){
+    std::unique_ptr<PdePageMap, decltype(page_map_deleter)> page_map(
+      page->AcquirePageMap(&CancelToken::CancelProc, cancel), page_map_deleter);
+    if (!page_map) {
+      CancelToken::ThrowIfStopped(cancel);
       throw PdfixException();
+    }
     
     PdeElement* container = page_map->GetElement();
     if (!container)
@@ -63,7 +66,9 @@ namespace ExtractText {
     const std::wstring& open_path,      // source PDF document
     std::ostream& output,                // output stream
     const std::wstring& config_path,     // configuration file
-    const int page_number
+    const int page_number,
+    const std::wstring& index_path,      // character geometry index or empty
+    CancelToken* cancel                  // cancel token or nullptr
     ) {
     // initialize Pdfix
     if (!Pdfix_init(Pdfix_MODULE_NAME))
@@ -79,6 +84,11 @@ namespace ExtractText {
 
     std::stringstream ss;
 
+    // the index is built from the same page map, the text is then written as indexed
+    std::unique_ptr<CharIndex::Writer> index;
+    if (!index_path.empty())
+      index.reset(new CharIndex::Writer(index_path));
+
     auto num_pages = doc->GetNumPages();
     auto from_page = page_number == -1 ? 0 : page_number;
     auto to_page = page_number == -1 ? num_pages - 1 : page_number;
@@ -87,8 +97,20 @@ namespace ExtractText {
       std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(i), page_deleter);
       if (!page)
         throw PdfixException();
-      GetPageText(page.get(), ss);
+      if (index) {
+        std::unique_ptr<PdePageMap, decltype(page_map_deleter)> page_map(
+          page->AcquirePageMap(&CancelToken::CancelProc, cancel), page_map_deleter);
+        if (!page_map || !page_map->GetElement()) {
+          CancelToken::ThrowIfStopped(cancel);
+          throw PdfixException();
+        }
+        ss << index->AddPage(page.get(), page_map->GetElement()) << std::endl;
+      }
+      else
+        GetPageText(page.get(), ss, cancel);
     }
+    if (index)
+      index->Close();
 
     // write text to stream
     output << ss.str();
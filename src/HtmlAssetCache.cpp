@@ -0,0 +1,139 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// HtmlAssetCache.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/HtmlAssetCache.h"
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <memory>
+#include <thread>
+#include "pdfixsdksamples/Utils.h"
+#include "Pdfix.h"
+#include "PdfToHtml.h"
+
+using namespace PDFixSDK;
+namespace fs = std::filesystem;
+
+static std::string SaveAsset(PdfToHtml* pdf_to_html, bool css) {
+  auto stm_deleter = [](PsStream* stm) { stm->Destroy(); };
+  std::unique_ptr<PsStream, decltype(stm_deleter)> stm(GetPdfix()->CreateMemStream(),
+    stm_deleter);
+  if (!stm)
+    throw PdfixException();
+  if (!(css ? pdf_to_html->SaveCSS(stm.get()) : pdf_to_html->SaveJavaScript(stm.get())))
+    throw PdfixException();
+  std::string data(stm->GetSize(), '\0');
+  if (!data.empty() && !stm->Read(0, (uint8_t*)&data[0], (int)data.size()))
+    throw PdfixException();
+  return data;
+}
+
+static bool ReadFile(const fs::path& path, std::string& data) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+    return false;
+  data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  return true;
+}
+
+// replaces the element enclosing content, e.g. <style>content</style>, with replacement
+static bool ReplaceElement(std::string& html, const std::string& content, const std::string& tag,
+  const std::string& replacement) {
+  if (content.empty())
+    return false;
+  auto pos = html.find(content);
+  if (pos == std::string::npos)
+    return false;
+  auto begin = html.rfind("<" + tag, pos);
+  auto end = html.find("</" + tag + ">", pos + content.size());
+  if (begin == std::string::npos || end == std::string::npos)
+    return false;
+  // only whitespace and the opening tag may surround the content
+  auto open_end = html.find('>', begin);
+  if (open_end == std::string::npos || open_end >= pos ||
+    html.find_first_not_of(" \t\r\n", open_end + 1) < pos ||
+    html.find_first_not_of(" \t\r\n", pos + content.size()) < end)
+    return false;
+  html.replace(begin, end + tag.size() + 3 - begin, replacement);
+  return true;
+}
+
+HtmlAssetCache::HtmlAssetCache(
+  const std::wstring& assets_dir,     // directory holding the assets
+  const std::string& assets_url       // URL of the directory used in the HTML, e.g. "assets/"
+) : dir_(assets_dir), url_(assets_url) {
+  fs::create_directories(dir_);
+}
+
+const HtmlAssets& HtmlAssetCache::Get(PdfToHtml* pdf_to_html) {
+  std::stringstream version;
+  version << pdf_to_html->GetVersionMajor() << "." << pdf_to_html->GetVersionMinor() << "." <<
+    pdf_to_html->GetVersionPatch();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (version_ == version.str())
+    return assets_;
+
+  auto manifest = "pdfix-html-" + version.str() + ".manifest";
+  if (!Load(manifest)) {
+    assets_.css = SaveAsset(pdf_to_html, true);
+    assets_.js = SaveAsset(pdf_to_html, false);
+    assets_.css_name = "pdfix." + HashToHex(Fnv1aHash(assets_.css.data(), assets_.css.size())) +
+      ".css";
+    assets_.js_name = "pdfix." + HashToHex(Fnv1aHash(assets_.js.data(), assets_.js.size())) +
+      ".js";
+    // Load failed, an existing file of the hashed name may be damaged, so both are written again.
+    // The rename replaces them in one step for documents already referring to them.
+    Store(assets_.css_name, assets_.css);
+    Store(assets_.js_name, assets_.js);
+    Store(manifest, assets_.css_name + "\n" + assets_.js_name + "\n");
+  }
+  version_ = version.str();
+  return assets_;
+}
+
+bool HtmlAssetCache::Externalize(PdfToHtml* pdf_to_html, std::string& html) {
+  auto& assets = Get(pdf_to_html);
+  bool css = ReplaceElement(html, assets.css, "style",
+    "<link rel=\"stylesheet\" href=\"" + url_ + assets.css_name + "\">");
+  bool js = ReplaceElement(html, assets.js, "script",
+    "<script src=\"" + url_ + assets.js_name + "\"></script>");
+  return css || js;
+}
+
+// reads the assets listed in the manifest, called with the mutex locked
+bool HtmlAssetCache::Load(const std::string& manifest) {
+  std::string names;
+  if (!ReadFile(dir_ / manifest, names))
+    return false;
+  std::stringstream ss(names);
+  HtmlAssets assets;
+  if (!std::getline(ss, assets.css_name) || !std::getline(ss, assets.js_name))
+    return false;
+  // the content is matched against the embedded assets, a damaged file is generated again
+  if (!ReadFile(dir_ / assets.css_name, assets.css) || !ReadFile(dir_ / assets.js_name, assets.js))
+    return false;
+  if ("pdfix." + HashToHex(Fnv1aHash(assets.css.data(), assets.css.size())) + ".css" !=
+    assets.css_name ||
+    "pdfix." + HashToHex(Fnv1aHash(assets.js.data(), assets.js.size())) + ".js" != assets.js_name)
+    return false;
+  assets_ = assets;
+  return true;
+}
+
+void HtmlAssetCache::Store(const std::string& name, const std::string& data) {
+  // write to a temporary file first, readers never see a partial asset
+  std::stringstream tmp_name;
+  tmp_name << name << "." << std::this_thread::get_id() << ".tmp";
+  auto tmp_path = dir_ / tmp_name.str();
+  {
+    std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+    file.write(data.data(), data.size());
+    if (!file)
+      throw std::runtime_error("HTML asset write fail");
+  }
+  fs::rename(tmp_path, dir_ / name);
+}
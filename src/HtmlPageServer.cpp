@@ -0,0 +1,423 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// HtmlPageServer.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/HtmlPageServer.h"
+
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <memory>
+#include <cstdlib>
+#include <exception>
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET socket_t;
+#define CloseSocket closesocket
+#else
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+typedef int socket_t;
+#define INVALID_SOCKET (-1)
+#define CloseSocket close
+#endif
+#include "pdfixsdksamples/Utils.h"
+#include "pdfixsdksamples/ConvertToHtmlParallel.h"
+#include "Pdfix.h"
+#include "PdfToHtml.h"
+
+using namespace PDFixSDK;
+namespace fs = std::filesystem;
+
+namespace HtmlPageServer {
+
+  // loads page placeholders when they get near the viewport and replaces them with the page
+  static const char* kLazyLoadScript =
+    "<script>\n"
+    "(function() {\n"
+    "  var observer = new IntersectionObserver(function(entries) {\n"
+    "    entries.forEach(function(entry) {\n"
+    "      if (!entry.isIntersecting) return;\n"
+    "      var placeholder = entry.target;\n"
+    "      observer.unobserve(placeholder);\n"
+    "      fetch(location.pathname + '/page/' + placeholder.dataset.page)\n"
+    "        .then(function(response) { return response.text(); })\n"
+    "        .then(function(html) { placeholder.outerHTML = html; });\n"
+    "    });\n"
+    "  }, { rootMargin: '200%' });\n"
+    "  document.querySelectorAll('.pdfix-lazy-page').forEach(function(placeholder) {\n"
+    "    observer.observe(placeholder);\n"
+    "  });\n"
+    "})();\n"
+    "</script>\n";
+
+  // file names only, no path separators or parent references
+  static bool IsValidName(const std::string& name) {
+    return !name.empty() && name.find_first_of("/\\") == std::string::npos &&
+      name.find("..") == std::string::npos;
+  }
+
+  PageCache::PageCache(
+    PdfToHtml* pdf_to_html,             // initialized PdfToHtml
+    const std::wstring& docs_dir,       // directory with the PDF documents
+    const PdfHtmlParams& html_params,   // conversion parameters
+    size_t max_docs,                    // max number of open documents
+    uint64_t max_bytes,                 // max total size of cached fragments
+    int prefetch_pages,                 // pages converted ahead of the requested one
+    HtmlAssetCache* assets              // shared CSS and JavaScript or nullptr to embed them
+  ) : pdf_to_html_(pdf_to_html), dir_(docs_dir), html_params_(html_params),
+      max_docs_(std::max<size_t>(max_docs, 1)), max_bytes_(max_bytes),
+      prefetch_pages_(prefetch_pages), assets_(assets), prefetch_queue_(64) {
+    // fragments are kept in memory, resources go inline
+    html_params_.flags |= kHtmlNoExternalCSS | kHtmlNoExternalJS | kHtmlNoExternalIMG |
+      kHtmlNoExternalFONT;
+    prefetcher_ = std::thread(&PageCache::Prefetch, this);
+  }
+
+  PageCache::~PageCache() {
+    prefetch_queue_.Close();
+    prefetcher_.join();
+    for (auto& doc : docs_)
+      CloseDoc(doc);
+  }
+
+  bool PageCache::GetDocHtml(const std::string& name, std::string& html) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto doc = AcquireDoc(name);
+    if (!doc)
+      return false;
+    html = doc->html;
+    return true;
+  }
+
+  bool PageCache::GetPageHtml(const std::string& name, int page_num, std::string& html) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      bool cached = index_.count(name + "#" + std::to_string(page_num - 1)) != 0;
+      if (!ConvertPage(name, page_num - 1, &html))
+        return false;
+      cached ? hits_++ : misses_++;
+    }
+    // readers scroll forward, convert the next pages while the page is being read; a full queue
+    // means the prefetcher is behind and the pages are converted on request
+    for (int i = 0; i < prefetch_pages_; i++) {
+      if (!prefetch_queue_.TryPush(std::make_pair(name, page_num + i)))
+        break;
+    }
+    return true;
+  }
+
+  // returns the open document, opens it when needed, called with the mutex locked
+  PageCache::Doc* PageCache::AcquireDoc(const std::string& name) {
+    for (auto it = docs_.begin(); it != docs_.end(); it++) {
+      if (it->name == name) {
+        docs_.splice(docs_.begin(), docs_, it);
+        return &docs_.front();
+      }
+    }
+
+    if (!IsValidName(name) || fs::path(name).extension() != ".pdf")
+      return nullptr;
+    auto path = dir_ / FromUtf8(name);
+    std::error_code ec;
+    if (!fs::is_regular_file(path, ec))
+      return nullptr;
+
+    Doc doc;
+    doc.name = name;
+    doc.doc = GetPdfix()->OpenDoc(path.wstring().c_str(), L"");
+    if (!doc.doc)
+      throw PdfixException();
+    try {
+      doc.html_doc = pdf_to_html_->OpenHtmlDoc(doc.doc);
+      if (!doc.html_doc)
+        throw PdfixException();
+
+      std::string shell = SaveHtmlShell(doc.html_doc, html_params_, nullptr);
+      if (assets_)
+        assets_->Externalize(pdf_to_html_, shell);
+
+      // placeholders keep the page proportions, so the scroll position is stable while loading
+      std::stringstream pages;
+      for (int i = 0; i < doc.doc->GetNumPages(); i++) {
+        auto page_deleter = [](PdfPage* page) { page->Release(); };
+        std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc.doc->AcquirePage(i),
+          page_deleter);
+        if (!page)
+          throw PdfixException();
+        PdfRect crop_box;
+        page->GetCropBox(&crop_box);
+        pages << "<div class=\"pdfix-lazy-page\" data-page=\"" << (i + 1) <<
+          "\" style=\"aspect-ratio: " << (crop_box.right - crop_box.left) << " / " <<
+          (crop_box.top - crop_box.bottom) << "\"></div>\n";
+      }
+      pages << kLazyLoadScript;
+      shell.insert(GetHtmlPagesPos(shell), pages.str());
+      doc.html = std::move(shell);
+    }
+    catch (...) {
+      CloseDoc(doc);
+      throw;
+    }
+
+    docs_.push_front(std::move(doc));
+    while (docs_.size() > max_docs_) {
+      CloseDoc(docs_.back());
+      docs_.pop_back();
+    }
+    return &docs_.front();
+  }
+
+  // converts the page unless it's cached, called with the mutex locked
+  bool PageCache::ConvertPage(const std::string& name, int page_num, std::string* html) {
+    auto key = name + "#" + std::to_string(page_num);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      fragments_.splice(fragments_.begin(), fragments_, it->second);
+      if (html)
+        *html = it->second->html;
+      return true;
+    }
+
+    auto doc = AcquireDoc(name);
+    if (!doc || page_num < 0 || page_num >= doc->doc->GetNumPages())
+      return false;
+    Fragment fragment;
+    fragment.key = key;
+    fragment.html = SaveHtmlPage(doc->html_doc, html_params_, page_num, nullptr);
+    if (html)
+      *html = fragment.html;
+
+    total_bytes_ += fragment.html.size();
+    fragments_.push_front(std::move(fragment));
+    index_[key] = fragments_.begin();
+    while (total_bytes_ > max_bytes_ && fragments_.size() > 1) {
+      total_bytes_ -= fragments_.back().html.size();
+      index_.erase(fragments_.back().key);
+      fragments_.pop_back();
+    }
+    return true;
+  }
+
+  // prefetch thread
+  void PageCache::Prefetch() {
+    std::pair<std::string, int> item;
+    while (prefetch_queue_.Pop(item)) {
+      try {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ConvertPage(item.first, item.second, nullptr);
+      }
+      catch (...) {
+        // the page is converted again on request, which reports the error
+      }
+    }
+  }
+
+  void PageCache::CloseDoc(Doc& doc) {
+    if (doc.html_doc)
+      doc.html_doc->Close();
+    if (doc.doc)
+      doc.doc->Close();
+    doc.html_doc = nullptr;
+    doc.doc = nullptr;
+  }
+
+  static std::string DecodeUrl(const std::string& url) {
+    std::string result;
+    for (size_t i = 0; i < url.size(); i++) {
+      if (url[i] == '%' && i + 2 < url.size()) {
+        result += (char)strtol(url.substr(i + 1, 2).c_str(), nullptr, 16);
+        i += 2;
+      }
+      else {
+        result += url[i];
+      }
+    }
+    return result;
+  }
+
+  // requests are served one at a time, a client that stops sending or reading must not stall the
+  // server, a timed out recv or send fails and the connection is closed
+  static void SetSocketTimeout(socket_t client, int timeout_ms) {
+#ifdef _WIN32
+    DWORD timeout = timeout_ms;
+#else
+    timeval timeout = { timeout_ms / 1000, (timeout_ms % 1000) * 1000 };
+#endif
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, (const char*)&timeout, sizeof(timeout));
+  }
+
+  static void SendAll(socket_t client, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+      int n = send(client, data.data() + sent, (int)(data.size() - sent), 0);
+      if (n <= 0)
+        return;
+      sent += n;
+    }
+  }
+
+  static void SendResponse(socket_t client, int status, const std::string& content_type,
+    const std::string& body) {
+    std::stringstream ss;
+    ss << "HTTP/1.1 " << status << (status == 200 ? " OK" : status == 404 ? " Not Found" :
+      " Internal Server Error") << "\r\n";
+    ss << "Content-Type: " << content_type << "\r\n";
+    ss << "Content-Length: " << body.size() << "\r\n";
+    ss << "Connection: close\r\n\r\n";
+    SendAll(client, ss.str() + body);
+  }
+
+  // reads the request line, returns the decoded path of a GET request or an empty string
+  static std::string ReadRequestPath(socket_t client) {
+    std::string request;
+    char buffer[4096];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < 16384) {
+      int n = recv(client, buffer, sizeof(buffer), 0);
+      if (n <= 0)
+        break;
+      request.append(buffer, n);
+    }
+    std::stringstream ss(request.substr(0, request.find("\r\n")));
+    std::string method, target;
+    ss >> method >> target;
+    if (method != "GET" || target.empty() || target[0] != '/')
+      return std::string();
+    return DecodeUrl(target.substr(0, target.find('?')));
+  }
+
+  static void HandleRequest(socket_t client, PageCache& cache, HtmlAssetCache* assets) {
+    auto path = ReadRequestPath(client);
+    const std::string html_type = "text/html; charset=utf-8";
+    std::string body;
+
+    // /assets/<file>
+    const std::string assets_prefix = "/assets/";
+    if (assets && path.compare(0, assets_prefix.size(), assets_prefix) == 0) {
+      auto name = path.substr(assets_prefix.size());
+      std::ifstream file(assets->GetDir() / name, std::ios::binary);
+      if (IsValidName(name) && file) {
+        body.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        auto ext = fs::path(name).extension();
+        SendResponse(client, 200, ext == ".css" ? "text/css" : ext == ".js" ?
+          "application/javascript" : "application/octet-stream", body);
+        return;
+      }
+      SendResponse(client, 404, html_type, "Not found");
+      return;
+    }
+
+    // /<name>.pdf/page/<n>
+    const std::string page_part = "/page/";
+    auto page_pos = path.rfind(page_part);
+    if (page_pos != std::string::npos && page_pos > 1) {
+      auto name = path.substr(1, page_pos - 1);
+      int page_num = atoi(path.substr(page_pos + page_part.size()).c_str());
+      if (page_num > 0 && cache.GetPageHtml(name, page_num, body)) {
+        SendResponse(client, 200, html_type, body);
+        return;
+      }
+    }
+    // /<name>.pdf
+    else if (path.size() > 1 && cache.GetDocHtml(path.substr(1), body)) {
+      SendResponse(client, 200, html_type, body);
+      return;
+    }
+    SendResponse(client, 404, html_type, "Not found");
+  }
+
+  void Run(
+    const std::wstring& docs_dir,       // directory with the PDF documents
+    int port,                           // loopback port to listen on
+    PdfHtmlParams& html_params,         // conversion parameters
+    size_t max_docs,                    // max number of open documents
+    uint64_t max_cache_bytes,           // max total size of cached fragments
+    int prefetch_pages,                 // pages converted ahead of the requested one
+    HtmlAssetCache* assets,             // shared CSS and JavaScript or nullptr to embed them
+    CancelToken* cancel                 // stops the server
+  ) {
+    // initialize Pdfix
+    if (!Pdfix_init(Pdfix_MODULE_NAME))
+      throw std::runtime_error("Pdfix initialization fail");
+
+    Pdfix* pdfix = GetPdfix();
+    if (!pdfix)
+      throw std::runtime_error("GetPdfix fail");
+
+    // initialize PdfToHtml
+    if (!PdfToHtml_init(PdfToHtml_MODULE_NAME))
+      throw std::runtime_error("PdfToHtml_init fail");
+
+    auto pdf_to_html = GetPdfToHtml();
+    if (!pdf_to_html)
+      throw std::runtime_error("GetPdfToHtml fail");
+
+    if (!pdf_to_html->Initialize(pdfix))
+      throw PdfixException();
+
+#ifdef _WIN32
+    WSADATA wsa_data;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0)
+      throw std::runtime_error("WSAStartup fail");
+#endif
+
+    {
+      PageCache cache(pdf_to_html, docs_dir, html_params, max_docs, max_cache_bytes,
+        prefetch_pages, assets);
+
+      auto socket_deleter = [](socket_t* s) { CloseSocket(*s); delete s; };
+      std::unique_ptr<socket_t, decltype(socket_deleter)> server(
+        new socket_t(socket(AF_INET, SOCK_STREAM, 0)), socket_deleter);
+      if (*server == INVALID_SOCKET)
+        throw std::runtime_error("Socket creation fail");
+      int reuse = 1;
+      setsockopt(*server, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+      // loopback only, the server is not reachable from other machines
+      sockaddr_in addr = {};
+      addr.sin_family = AF_INET;
+      addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      addr.sin_port = htons((unsigned short)port);
+      if (bind(*server, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(*server, 16) != 0)
+        throw std::runtime_error("Socket bind fail");
+      std::cout << "Serving " << ToUtf8(docs_dir) << " on http://127.0.0.1:" << port << "/"
+        << std::endl;
+
+      while (!cancel || !cancel->IsStopped()) {
+        // wake up regularly to check the cancel token
+        fd_set fds;
+        FD_ZERO(&fds);
+        FD_SET(*server, &fds);
+        timeval timeout = { 0, 200000 };
+        if (select((int)*server + 1, &fds, nullptr, nullptr, &timeout) <= 0)
+          continue;
+        socket_t client = accept(*server, nullptr, nullptr);
+        if (client == INVALID_SOCKET)
+          continue;
+        SetSocketTimeout(client, 5000);
+        try {
+          HandleRequest(client, cache, assets);
+        }
+        catch (std::exception& e) {
+          SendResponse(client, 500, "text/plain", e.what());
+        }
+        CloseSocket(client);
+      }
+      std::cout << "Pages served from cache: " << cache.GetHits() << ", converted: " <<
+        cache.GetMisses() << std::endl;
+    }
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    pdf_to_html->Destroy();
+    pdfix->Destroy();
+  }
+}
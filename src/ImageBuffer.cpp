@@ -0,0 +1,890 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// ImageBuffer.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/ImageBuffer.h"
+
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#ifdef PDFIX_SAMPLES_ZLIB
+#include <zlib.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PDFIX_SAMPLES_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define PDFIX_SAMPLES_NEON
+#include <arm_neon.h>
+#endif
+#include "pdfixsdksamples/Utils.h"
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+void ImageBuffer::Create(int w, int h, ImageBufferFormat f) {
+  width = w;
+  height = h;
+  format = f;
+  switch (format) {
+    case kImageBufferBgra: stride = width * 4; break;
+    case kImageBufferGray: stride = width; break;
+    case kImageBufferBitonal: stride = (width + 7) / 8; break;
+  }
+  data.assign((size_t)stride * height, 0);
+}
+
+void ReadImagePixels(PsImage* image, int width, int height, ImageBuffer& buffer) {
+  auto stm_deleter = [](PsStream* stm) { stm->Destroy(); };
+  std::unique_ptr<PsStream, decltype(stm_deleter)> stm(GetPdfix()->CreateMemStream(), stm_deleter);
+  if (!stm)
+    throw PdfixException();
+  if (!image->SaveDataToStream(stm.get()))
+    throw PdfixException();
+
+  buffer.Create(width, height, kImageBufferBgra);
+  int size = stm->GetSize();
+  if (height == 0 || size < buffer.stride * height)
+    throw std::runtime_error("Unexpected image data size");
+
+  // rows of the image data can be padded
+  int src_stride = size / height;
+  std::vector<uint8_t> row(src_stride);
+  for (int y = 0; y < height; y++) {
+    if (!stm->Read(y * src_stride, row.data(), src_stride))
+      throw PdfixException();
+    memcpy(buffer.Row(y), row.data(), buffer.stride);
+  }
+}
+
+void WriteImagePixels(const ImageBuffer& buffer, PsImage* image) {
+  auto stm = image->GetDataStm();
+  if (!stm)
+    throw PdfixException();
+  int row_size = buffer.width * 4;
+  int size = stm->GetSize();
+  if (buffer.height == 0 || size < row_size * buffer.height)
+    throw std::runtime_error("Unexpected image data size");
+
+  // rows of the image data can be padded
+  int dst_stride = size / buffer.height;
+  std::vector<uint8_t> row(row_size);
+  for (int y = 0; y < buffer.height; y++) {
+    const uint8_t* src = buffer.Row(y);
+    if (buffer.format == kImageBufferBgra) {
+      memcpy(row.data(), src, row_size);
+    }
+    else {
+      for (int x = 0; x < buffer.width; x++) {
+        uint8_t value = buffer.format == kImageBufferGray ? src[x] :
+          (src[x / 8] & (0x80 >> (x % 8))) ? 255 : 0;
+        uint8_t* pixel = row.data() + x * 4;
+        pixel[0] = pixel[1] = pixel[2] = value;
+        pixel[3] = 255;
+      }
+    }
+    if (!stm->Write(y * dst_stride, row.data(), row_size))
+      throw PdfixException();
+  }
+}
+
+void BlitImageBuffer(const ImageBuffer& src, ImageBuffer& dst, int x, int y) {
+  if (src.format != dst.format || src.format == kImageBufferBitonal)
+    throw std::runtime_error("Unsupported image buffer format");
+  int bpp = src.format == kImageBufferBgra ? 4 : 1;
+  int w = std::min(src.width, dst.width - x);
+  int h = std::min(src.height, dst.height - y);
+  for (int row = 0; row < h; row++)
+    memcpy(dst.Row(y + row) + x * bpp, src.Row(row), (size_t)w * bpp);
+}
+
+void DownscaleHalf(const ImageBuffer& src, ImageBuffer& dst) {
+  if (src.format == kImageBufferBitonal)
+    throw std::runtime_error("Unsupported image buffer format");
+  int bpp = src.format == kImageBufferBgra ? 4 : 1;
+  dst.Create((src.width + 1) / 2, (src.height + 1) / 2, src.format);
+  for (int y = 0; y < dst.height; y++) {
+    const uint8_t* row0 = src.Row(2 * y);
+    const uint8_t* row1 = src.Row(std::min(2 * y + 1, src.height - 1));
+    uint8_t* out = dst.Row(y);
+    for (int x = 0; x < dst.width; x++) {
+      int x0 = 2 * x * bpp;
+      int x1 = std::min(2 * x + 1, src.width - 1) * bpp;
+      for (int c = 0; c < bpp; c++)
+        out[x * bpp + c] = (uint8_t)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4);
+    }
+  }
+}
+
+// filter taps of one output pixel, weights are fixed point with kWeightBits fraction bits
+struct ResampleTaps {
+  int first;
+  std::vector<int16_t> weights;
+};
+
+static const int kWeightBits = 14;
+
+static double LanczosKernel(double x) {
+  const double kPiD = 3.14159265358979323846;
+  x = std::fabs(x);
+  if (x < 1e-8)
+    return 1;
+  if (x >= 3)
+    return 0;
+  return 3 * std::sin(kPiD * x) * std::sin(kPiD * x / 3) / (kPiD * kPiD * x * x);
+}
+
+static std::vector<ResampleTaps> ComputeTaps(int src_size, int dst_size,
+  ImageResampleFilter filter) {
+  double scale = (double)src_size / dst_size;
+  double filter_scale = std::max(1.0, scale);
+  double support = (filter == kResampleBox ? 0.5 : 3.0) * filter_scale;
+
+  std::vector<ResampleTaps> taps(dst_size);
+  std::vector<double> weights;
+  for (int i = 0; i < dst_size; i++) {
+    double center = (i + 0.5) * scale;
+    int first = std::max(0, (int)std::floor(center - support));
+    int last = std::min(src_size - 1, (int)std::ceil(center + support));
+    weights.clear();
+    double total = 0;
+    for (int j = first; j <= last; j++) {
+      double w = 0;
+      if (filter == kResampleBox) {
+        // coverage of the source pixel by the output pixel footprint
+        double left = std::max<double>(j, center - support);
+        double right = std::min<double>(j + 1, center + support);
+        w = std::max(0.0, right - left);
+      }
+      else {
+        w = LanczosKernel((j + 0.5 - center) / filter_scale);
+      }
+      weights.push_back(w);
+      total += w;
+    }
+    // normalise to 1 << kWeightBits, the rounding error goes to the biggest weight
+    auto& t = taps[i];
+    t.first = first;
+    t.weights.resize(weights.size());
+    int sum = 0;
+    size_t max_index = 0;
+    for (size_t k = 0; k < weights.size(); k++) {
+      t.weights[k] = (int16_t)std::lround(weights[k] / total * (1 << kWeightBits));
+      sum += t.weights[k];
+      if (t.weights[k] > t.weights[max_index])
+        max_index = k;
+    }
+    t.weights[max_index] += (int16_t)((1 << kWeightBits) - sum);
+  }
+  return taps;
+}
+
+static inline uint8_t ClampToByte(int value) {
+  value = (value + (1 << (kWeightBits - 1))) >> kWeightBits;
+  return (uint8_t)std::min(255, std::max(0, value));
+}
+
+// dst[x] = sum(rows[k][x] * weights[k]) for size bytes
+static void ResampleColumn(const uint8_t* const* rows, const int16_t* weights, int num_taps,
+  uint8_t* dst, int size) {
+  int x = 0;
+#if defined(PDFIX_SAMPLES_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i round = _mm_set1_epi32(1 << (kWeightBits - 1));
+  for (; x + 8 <= size; x += 8) {
+    __m128i lo = round, hi = round;
+    int k = 0;
+    // two rows at a time, interleaved 16-bit pixels are multiplied by weight pairs with madd
+    for (; k + 1 < num_taps; k += 2) {
+      __m128i a = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(rows[k] + x)), zero);
+      __m128i b = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(rows[k + 1] + x)), zero);
+      __m128i w = _mm_set1_epi32((int)(((uint32_t)(uint16_t)weights[k + 1] << 16) |
+        (uint16_t)weights[k]));
+      lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), w));
+      hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), w));
+    }
+    if (k < num_taps) {
+      __m128i a = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(rows[k] + x)), zero);
+      __m128i w = _mm_set1_epi32((uint16_t)weights[k]);
+      lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, zero), w));
+      hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, zero), w));
+    }
+    lo = _mm_srai_epi32(lo, kWeightBits);
+    hi = _mm_srai_epi32(hi, kWeightBits);
+    __m128i packed = _mm_packus_epi16(_mm_packs_epi32(lo, hi), zero);
+    _mm_storel_epi64((__m128i*)(dst + x), packed);
+  }
+#elif defined(PDFIX_SAMPLES_NEON)
+  for (; x + 8 <= size; x += 8) {
+    int32x4_t lo = vdupq_n_s32(1 << (kWeightBits - 1));
+    int32x4_t hi = lo;
+    for (int k = 0; k < num_taps; k++) {
+      int16x8_t a = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(rows[k] + x)));
+      lo = vmlal_n_s16(lo, vget_low_s16(a), weights[k]);
+      hi = vmlal_n_s16(hi, vget_high_s16(a), weights[k]);
+    }
+    int16x8_t packed = vcombine_s16(vqshrn_n_s32(lo, kWeightBits), vqshrn_n_s32(hi, kWeightBits));
+    vst1_u8(dst + x, vqmovun_s16(packed));
+  }
+#endif
+  for (; x < size; x++) {
+    int sum = 0;
+    for (int k = 0; k < num_taps; k++)
+      sum += rows[k][x] * weights[k];
+    dst[x] = ClampToByte(sum);
+  }
+}
+
+void ResizeImageBuffer(const ImageBuffer& src, ImageBuffer& dst, int width, int height,
+  ImageResampleFilter filter) {
+  if (src.format == kImageBufferBitonal)
+    throw std::runtime_error("Unsupported image buffer format");
+  if (width <= 0 || height <= 0 || src.width <= 0 || src.height <= 0)
+    throw std::runtime_error("Invalid image size");
+  int bpp = src.format == kImageBufferBgra ? 4 : 1;
+
+  // horizontal pass into rows of the final width
+  auto h_taps = ComputeTaps(src.width, width, filter);
+  ImageBuffer tmp;
+  tmp.Create(width, src.height, src.format);
+  for (int y = 0; y < src.height; y++) {
+    const uint8_t* in = src.Row(y);
+    uint8_t* out = tmp.Row(y);
+    for (int x = 0; x < width; x++) {
+      auto& t = h_taps[x];
+      for (int c = 0; c < bpp; c++) {
+        int sum = 0;
+        const uint8_t* p = in + t.first * bpp + c;
+        for (size_t k = 0; k < t.weights.size(); k++, p += bpp)
+          sum += *p * t.weights[k];
+        out[x * bpp + c] = ClampToByte(sum);
+      }
+    }
+  }
+
+  // vertical pass, all channels of a row share the weights
+  auto v_taps = ComputeTaps(src.height, height, filter);
+  dst.Create(width, height, src.format);
+  std::vector<const uint8_t*> rows;
+  for (int y = 0; y < height; y++) {
+    auto& t = v_taps[y];
+    rows.resize(t.weights.size());
+    for (size_t k = 0; k < rows.size(); k++)
+      rows[k] = tmp.Row(t.first + (int)k);
+    ResampleColumn(rows.data(), t.weights.data(), (int)rows.size(), dst.Row(y), width * bpp);
+  }
+}
+
+// luma = (77 R + 150 G + 29 B + 128) / 256
+static void ConvertRowToGray(const uint8_t* src, uint8_t* dst, int width) {
+  int x = 0;
+#if defined(PDFIX_SAMPLES_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i weights = _mm_setr_epi16(29, 150, 77, 0, 29, 150, 77, 0);
+  const __m128i round = _mm_set1_epi32(128);
+  // 4 BGRA pixels into 4 32-bit luma values
+  auto luma4 = [&](const uint8_t* p) {
+    __m128i px = _mm_loadu_si128((const __m128i*)p);
+    __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(px, zero), weights);
+    __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(px, zero), weights);
+    __m128i bg = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi),
+      _MM_SHUFFLE(2, 0, 2, 0)));
+    __m128i ra = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi),
+      _MM_SHUFFLE(3, 1, 3, 1)));
+    return _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(bg, ra), round), 8);
+  };
+  for (; x + 16 <= width; x += 16) {
+    const uint8_t* p = src + x * 4;
+    __m128i l0 = _mm_packs_epi32(luma4(p), luma4(p + 16));
+    __m128i l1 = _mm_packs_epi32(luma4(p + 32), luma4(p + 48));
+    _mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(l0, l1));
+  }
+#elif defined(PDFIX_SAMPLES_NEON)
+  for (; x + 8 <= width; x += 8) {
+    uint8x8x4_t px = vld4_u8(src + x * 4);
+    uint16x8_t sum = vmull_u8(px.val[0], vdup_n_u8(29));
+    sum = vmlal_u8(sum, px.val[1], vdup_n_u8(150));
+    sum = vmlal_u8(sum, px.val[2], vdup_n_u8(77));
+    vst1_u8(dst + x, vrshrn_n_u16(sum, 8));
+  }
+#endif
+  for (; x < width; x++) {
+    const uint8_t* p = src + x * 4;
+    dst[x] = (uint8_t)((77 * p[2] + 150 * p[1] + 29 * p[0] + 128) >> 8);
+  }
+}
+
+void ConvertToGray(const ImageBuffer& src, ImageBuffer& dst) {
+  if (src.format != kImageBufferBgra)
+    throw std::runtime_error("Unsupported image buffer format");
+  dst.Create(src.width, src.height, kImageBufferGray);
+  for (int y = 0; y < src.height; y++)
+    ConvertRowToGray(src.Row(y), dst.Row(y), src.width);
+}
+
+void ThresholdAdaptive(const ImageBuffer& src, ImageBuffer& dst, int window, int bias) {
+  if (src.format != kImageBufferGray)
+    throw std::runtime_error("Unsupported image buffer format");
+  dst.Create(src.width, src.height, kImageBufferBitonal);
+  int radius = std::max(1, window / 2);
+
+  // sliding window - column sums of the rows inside the window, memory stays O(width)
+  std::vector<uint32_t> col_sums(src.width, 0);
+  std::vector<uint32_t> row_sums(src.width + 1, 0);
+  int top = 0, bottom = -1;
+  for (int y = 0; y < src.height; y++) {
+    int new_top = std::max(0, y - radius);
+    int new_bottom = std::min(src.height - 1, y + radius);
+    for (; bottom < new_bottom; bottom++) {
+      const uint8_t* row = src.Row(bottom + 1);
+      for (int x = 0; x < src.width; x++)
+        col_sums[x] += row[x];
+    }
+    for (; top < new_top; top++) {
+      const uint8_t* row = src.Row(top);
+      for (int x = 0; x < src.width; x++)
+        col_sums[x] -= row[x];
+    }
+    for (int x = 0; x < src.width; x++)
+      row_sums[x + 1] = row_sums[x] + col_sums[x];
+
+    int rows = bottom - top + 1;
+    const uint8_t* in = src.Row(y);
+    uint8_t* out = dst.Row(y);
+    for (int x = 0; x < src.width; x++) {
+      int left = std::max(0, x - radius);
+      int right = std::min(src.width - 1, x + radius);
+      uint64_t sum = row_sums[right + 1] - row_sums[left];
+      uint64_t count = (uint64_t)rows * (right - left + 1);
+      // white when value >= mean * (100 - bias) / 100
+      if ((uint64_t)in[x] * count * 100 >= sum * (100 - bias))
+        out[x / 8] |= (uint8_t)(0x80 >> (x % 8));
+    }
+  }
+}
+
+int OtsuThreshold(const ImageBuffer& src) {
+  if (src.format != kImageBufferGray)
+    throw std::runtime_error("Unsupported image buffer format");
+  uint64_t histogram[256] = { 0 };
+  for (int y = 0; y < src.height; y++) {
+    const uint8_t* row = src.Row(y);
+    for (int x = 0; x < src.width; x++)
+      histogram[row[x]]++;
+  }
+
+  // maximize the between-class variance
+  double total = (double)src.width * src.height;
+  double sum = 0;
+  for (int i = 0; i < 256; i++)
+    sum += (double)i * histogram[i];
+  double sum_back = 0, weight_back = 0, best = -1;
+  int threshold = 128;
+  for (int i = 0; i < 256; i++) {
+    weight_back += histogram[i];
+    if (weight_back == 0)
+      continue;
+    double weight_fore = total - weight_back;
+    if (weight_fore == 0)
+      break;
+    sum_back += (double)i * histogram[i];
+    double diff = sum_back / weight_back - (sum - sum_back) / weight_fore;
+    double variance = weight_back * weight_fore * diff * diff;
+    if (variance > best) {
+      best = variance;
+      threshold = i + 1;
+    }
+  }
+  return threshold;
+}
+
+// bit 0 to bit 7, movemask puts the first pixel into the least significant bit
+static inline uint8_t ReverseBits(uint32_t b) {
+  b = ((b & 0xf0) >> 4) | ((b & 0x0f) << 4);
+  b = ((b & 0xcc) >> 2) | ((b & 0x33) << 2);
+  return (uint8_t)(((b & 0xaa) >> 1) | ((b & 0x55) << 1));
+}
+
+void ThresholdGlobal(const ImageBuffer& src, ImageBuffer& dst, int threshold) {
+  if (src.format != kImageBufferGray)
+    throw std::runtime_error("Unsupported image buffer format");
+  dst.Create(src.width, src.height, kImageBufferBitonal);
+  if (threshold > 255)
+    return;
+  uint8_t level = (uint8_t)std::max(0, threshold);
+  for (int y = 0; y < src.height; y++) {
+    const uint8_t* in = src.Row(y);
+    uint8_t* out = dst.Row(y);
+    int x = 0;
+#if defined(PDFIX_SAMPLES_SSE2)
+    const __m128i t = _mm_set1_epi8((char)level);
+    for (; x + 16 <= src.width; x += 16) {
+      __m128i v = _mm_loadu_si128((const __m128i*)(in + x));
+      // unsigned v >= t
+      int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(v, t), v));
+      out[x / 8] = ReverseBits(mask & 0xff);
+      out[x / 8 + 1] = ReverseBits(mask >> 8);
+    }
+#elif defined(PDFIX_SAMPLES_NEON)
+    const uint8x16_t t = vdupq_n_u8(level);
+    static const uint8_t kBits[16] = {
+      0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+      0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01 };
+    const uint8x16_t bits = vld1q_u8(kBits);
+    for (; x + 16 <= src.width; x += 16) {
+      uint8x16_t v = vandq_u8(vcgeq_u8(vld1q_u8(in + x), t), bits);
+      uint8x8_t p = vpadd_u8(vget_low_u8(v), vget_high_u8(v));
+      p = vpadd_u8(p, p);
+      p = vpadd_u8(p, p);
+      out[x / 8] = vget_lane_u8(p, 0);
+      out[x / 8 + 1] = vget_lane_u8(p, 1);
+    }
+#endif
+    for (; x < src.width; x++) {
+      if (in[x] >= level)
+        out[x / 8] |= (uint8_t)(0x80 >> (x % 8));
+    }
+  }
+}
+
+// adds or subtracts a row from the window column sums and sums of squares
+static void UpdateColumnSums(const uint8_t* row, uint32_t* sums, uint32_t* sq_sums, int width,
+  bool add) {
+  int x = 0;
+#if defined(PDFIX_SAMPLES_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  for (; x + 8 <= width; x += 8) {
+    __m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(row + x)), zero);
+    // 255 * 255 fits into 16 unsigned bits
+    __m128i sq = _mm_mullo_epi16(v, v);
+    __m128i v_lo = _mm_unpacklo_epi16(v, zero), v_hi = _mm_unpackhi_epi16(v, zero);
+    __m128i sq_lo = _mm_unpacklo_epi16(sq, zero), sq_hi = _mm_unpackhi_epi16(sq, zero);
+    __m128i* s = (__m128i*)(sums + x);
+    __m128i* q = (__m128i*)(sq_sums + x);
+    if (add) {
+      _mm_storeu_si128(s, _mm_add_epi32(_mm_loadu_si128(s), v_lo));
+      _mm_storeu_si128(s + 1, _mm_add_epi32(_mm_loadu_si128(s + 1), v_hi));
+      _mm_storeu_si128(q, _mm_add_epi32(_mm_loadu_si128(q), sq_lo));
+      _mm_storeu_si128(q + 1, _mm_add_epi32(_mm_loadu_si128(q + 1), sq_hi));
+    }
+    else {
+      _mm_storeu_si128(s, _mm_sub_epi32(_mm_loadu_si128(s), v_lo));
+      _mm_storeu_si128(s + 1, _mm_sub_epi32(_mm_loadu_si128(s + 1), v_hi));
+      _mm_storeu_si128(q, _mm_sub_epi32(_mm_loadu_si128(q), sq_lo));
+      _mm_storeu_si128(q + 1, _mm_sub_epi32(_mm_loadu_si128(q + 1), sq_hi));
+    }
+  }
+#elif defined(PDFIX_SAMPLES_NEON)
+  for (; x + 8 <= width; x += 8) {
+    uint16x8_t v = vmovl_u8(vld1_u8(row + x));
+    uint32x4_t sq_lo = vmull_u16(vget_low_u16(v), vget_low_u16(v));
+    uint32x4_t sq_hi = vmull_u16(vget_high_u16(v), vget_high_u16(v));
+    uint32x4_t s_lo = vld1q_u32(sums + x), s_hi = vld1q_u32(sums + x + 4);
+    uint32x4_t q_lo = vld1q_u32(sq_sums + x), q_hi = vld1q_u32(sq_sums + x + 4);
+    if (add) {
+      s_lo = vaddw_u16(s_lo, vget_low_u16(v));
+      s_hi = vaddw_u16(s_hi, vget_high_u16(v));
+      q_lo = vaddq_u32(q_lo, sq_lo);
+      q_hi = vaddq_u32(q_hi, sq_hi);
+    }
+    else {
+      s_lo = vsubw_u16(s_lo, vget_low_u16(v));
+      s_hi = vsubw_u16(s_hi, vget_high_u16(v));
+      q_lo = vsubq_u32(q_lo, sq_lo);
+      q_hi = vsubq_u32(q_hi, sq_hi);
+    }
+    vst1q_u32(sums + x, s_lo);
+    vst1q_u32(sums + x + 4, s_hi);
+    vst1q_u32(sq_sums + x, q_lo);
+    vst1q_u32(sq_sums + x + 4, q_hi);
+  }
+#endif
+  for (; x < width; x++) {
+    uint32_t v = row[x];
+    if (add) {
+      sums[x] += v;
+      sq_sums[x] += v * v;
+    }
+    else {
+      sums[x] -= v;
+      sq_sums[x] -= v * v;
+    }
+  }
+}
+
+void ThresholdSauvola(const ImageBuffer& src, ImageBuffer& dst, int window, double k) {
+  if (src.format != kImageBufferGray)
+    throw std::runtime_error("Unsupported image buffer format");
+  dst.Create(src.width, src.height, kImageBufferBitonal);
+  int radius = std::max(1, window / 2);
+
+  // sliding window as in ThresholdAdaptive, column sums of squares fit 32 bits for windows
+  // below 66000 rows
+  std::vector<uint32_t> col_sums(src.width, 0), col_sq_sums(src.width, 0);
+  std::vector<uint64_t> row_sums(src.width + 1, 0), row_sq_sums(src.width + 1, 0);
+  int top = 0, bottom = -1;
+  for (int y = 0; y < src.height; y++) {
+    int new_top = std::max(0, y - radius);
+    int new_bottom = std::min(src.height - 1, y + radius);
+    for (; bottom < new_bottom; bottom++)
+      UpdateColumnSums(src.Row(bottom + 1), col_sums.data(), col_sq_sums.data(), src.width, true);
+    for (; top < new_top; top++)
+      UpdateColumnSums(src.Row(top), col_sums.data(), col_sq_sums.data(), src.width, false);
+    for (int x = 0; x < src.width; x++) {
+      row_sums[x + 1] = row_sums[x] + col_sums[x];
+      row_sq_sums[x + 1] = row_sq_sums[x] + col_sq_sums[x];
+    }
+
+    int rows = bottom - top + 1;
+    const uint8_t* in = src.Row(y);
+    uint8_t* out = dst.Row(y);
+    for (int x = 0; x < src.width; x++) {
+      int left = std::max(0, x - radius);
+      int right = std::min(src.width - 1, x + radius);
+      double count = (double)rows * (right - left + 1);
+      double mean = (row_sums[right + 1] - row_sums[left]) / count;
+      double variance = (row_sq_sums[right + 1] - row_sq_sums[left]) / count - mean * mean;
+      double deviation = std::sqrt(std::max(0., variance));
+      if (in[x] > mean * (1 + k * (deviation / 128 - 1)))
+        out[x / 8] |= (uint8_t)(0x80 >> (x % 8));
+    }
+  }
+}
+
+static inline bool IsBlack(const ImageBuffer& buffer, int x, int y) {
+  return !(buffer.Row(y)[x / 8] & (0x80 >> (x % 8)));
+}
+
+double EstimateSkew(const ImageBuffer& src, double max_angle, double precision) {
+  if (src.format != kImageBufferBitonal)
+    throw std::runtime_error("Unsupported image buffer format");
+
+  // black pixels, sampled down to a fixed number
+  uint64_t num_black = 0;
+  for (int y = 0; y < src.height; y++)
+    for (int x = 0; x < src.width; x++)
+      num_black += IsBlack(src, x, y);
+  if (num_black == 0)
+    return 0;
+  const uint64_t max_points = 1 << 18;
+  uint64_t step = (num_black + max_points - 1) / max_points, n = 0;
+  std::vector<std::pair<int, int>> points;
+  points.reserve((size_t)std::min(num_black, max_points));
+  for (int y = 0; y < src.height; y++) {
+    const uint8_t* row = src.Row(y);
+    for (int x = 0; x < src.width; x++) {
+      // skip white bytes at once
+      if (x % 8 == 0 && row[x / 8] == 0xff && x + 8 <= src.width) {
+        x += 7;
+        continue;
+      }
+      if (IsBlack(src, x, y) && n++ % step == 0)
+        points.push_back(std::make_pair(x, y));
+    }
+  }
+
+  // aligned text lines give the sharpest profile, the highest sum of squared bin counts
+  double max_tan = std::tan(max_angle * kPi / 180);
+  int offset = (int)std::ceil(src.width * max_tan) + 1;
+  std::vector<uint32_t> bins(src.height + 2 * offset);
+  auto score = [&](double angle) {
+    std::fill(bins.begin(), bins.end(), 0);
+    double t = std::tan(angle * kPi / 180);
+    for (auto& p : points)
+      bins[(int)(p.second - p.first * t) + offset]++;
+    double result = 0;
+    for (auto b : bins)
+      result += (double)b * b;
+    return result;
+  };
+  auto search = [&](double from, double to, double step) {
+    double best_angle = 0, best_score = -1;
+    for (double angle = from; angle <= to + step / 2; angle += step) {
+      double s = score(std::max(-max_angle, std::min(max_angle, angle)));
+      if (s > best_score) {
+        best_score = s;
+        best_angle = angle;
+      }
+    }
+    return best_angle;
+  };
+  double coarse = std::max(precision, max_angle / 10);
+  double angle = search(-max_angle, max_angle, coarse);
+  return std::max(-max_angle, std::min(max_angle, search(angle - coarse, angle + coarse,
+    precision)));
+}
+
+void RotateImageBuffer(const ImageBuffer& src, ImageBuffer& dst, double angle) {
+  if (src.format != kImageBufferGray && src.format != kImageBufferBitonal)
+    throw std::runtime_error("Unsupported image buffer format");
+  dst.Create(src.width, src.height, src.format);
+  double cos_a = std::cos(angle * kPi / 180), sin_a = std::sin(angle * kPi / 180);
+  double cx = src.width / 2., cy = src.height / 2.;
+  for (int y = 0; y < dst.height; y++) {
+    uint8_t* out = dst.Row(y);
+    double dy = y + 0.5 - cy;
+    for (int x = 0; x < dst.width; x++) {
+      // source point of the pixel center
+      double dx = x + 0.5 - cx;
+      double sx = cx + cos_a * dx - sin_a * dy - 0.5;
+      double sy = cy + sin_a * dx + cos_a * dy - 0.5;
+      if (src.format == kImageBufferBitonal) {
+        int ix = (int)std::floor(sx + 0.5), iy = (int)std::floor(sy + 0.5);
+        if (ix < 0 || iy < 0 || ix >= src.width || iy >= src.height || !IsBlack(src, ix, iy))
+          out[x / 8] |= (uint8_t)(0x80 >> (x % 8));
+        continue;
+      }
+      // bilinear, white outside of the source
+      int x0 = (int)std::floor(sx), y0 = (int)std::floor(sy);
+      double fx = sx - x0, fy = sy - y0;
+      auto at = [&](int px, int py) {
+        if (px < 0 || py < 0 || px >= src.width || py >= src.height)
+          return 255.;
+        return (double)src.Row(py)[px];
+      };
+      double v = (at(x0, y0) * (1 - fx) + at(x0 + 1, y0) * fx) * (1 - fy) +
+        (at(x0, y0 + 1) * (1 - fx) + at(x0 + 1, y0 + 1) * fx) * fy;
+      out[x] = ClampToByte((int)(v + 0.5));
+    }
+  }
+}
+
+void Despeckle(ImageBuffer& buffer) {
+  if (buffer.format != kImageBufferBitonal)
+    throw std::runtime_error("Unsupported image buffer format");
+  int row_bytes = (buffer.width + 7) / 8;
+  if (row_bytes == 0 || buffer.height == 0)
+    return;
+
+  // inverted copy, 1 is black, with an empty byte on each side of a row and an empty row above
+  // and below, so that neighbours never fall out of the buffer
+  int padded = row_bytes + 2;
+  std::vector<uint8_t> black((size_t)padded * (buffer.height + 2), 0);
+  uint8_t last_mask = (uint8_t)(0xff << ((8 - buffer.width % 8) % 8));
+  for (int y = 0; y < buffer.height; y++) {
+    const uint8_t* in = buffer.Row(y);
+    uint8_t* row = black.data() + (size_t)(y + 1) * padded + 1;
+    for (int i = 0; i < row_bytes; i++)
+      row[i] = (uint8_t)~in[i];
+    row[row_bytes - 1] &= last_mask;
+  }
+
+  for (int y = 0; y < buffer.height; y++) {
+    const uint8_t* up = black.data() + (size_t)y * padded + 1;
+    const uint8_t* mid = up + padded;
+    const uint8_t* down = mid + padded;
+    uint8_t* out = buffer.Row(y);
+    int i = 0;
+#if defined(PDFIX_SAMPLES_SSE2)
+    const __m128i low7 = _mm_set1_epi8(0x7f), high1 = _mm_set1_epi8((char)0x80);
+    const __m128i high7 = _mm_set1_epi8((char)0xfe), low1 = _mm_set1_epi8(0x01);
+    // per byte shifts, bits of pixel x - 1 and x + 1 moved to pixel x
+    auto left = [&](const uint8_t* p) {
+      return _mm_or_si128(
+        _mm_and_si128(_mm_srli_epi16(_mm_loadu_si128((const __m128i*)p), 1), low7),
+        _mm_and_si128(_mm_slli_epi16(_mm_loadu_si128((const __m128i*)(p - 1)), 7), high1));
+    };
+    auto right = [&](const uint8_t* p) {
+      return _mm_or_si128(
+        _mm_and_si128(_mm_slli_epi16(_mm_loadu_si128((const __m128i*)p), 1), high7),
+        _mm_and_si128(_mm_srli_epi16(_mm_loadu_si128((const __m128i*)(p + 1)), 7), low1));
+    };
+    for (; i + 16 <= row_bytes; i += 16) {
+      __m128i neighbours = _mm_or_si128(
+        _mm_or_si128(_mm_loadu_si128((const __m128i*)(up + i)),
+          _mm_loadu_si128((const __m128i*)(down + i))),
+        _mm_or_si128(_mm_or_si128(left(up + i), right(up + i)),
+          _mm_or_si128(_mm_or_si128(left(mid + i), right(mid + i)),
+            _mm_or_si128(left(down + i), right(down + i)))));
+      __m128i isolated = _mm_andnot_si128(neighbours,
+        _mm_loadu_si128((const __m128i*)(mid + i)));
+      __m128i* p = (__m128i*)(out + i);
+      _mm_storeu_si128(p, _mm_or_si128(_mm_loadu_si128(p), isolated));
+    }
+#elif defined(PDFIX_SAMPLES_NEON)
+    auto left = [&](const uint8_t* p) {
+      return vorrq_u8(vshrq_n_u8(vld1q_u8(p), 1), vshlq_n_u8(vld1q_u8(p - 1), 7));
+    };
+    auto right = [&](const uint8_t* p) {
+      return vorrq_u8(vshlq_n_u8(vld1q_u8(p), 1), vshrq_n_u8(vld1q_u8(p + 1), 7));
+    };
+    for (; i + 16 <= row_bytes; i += 16) {
+      uint8x16_t neighbours = vorrq_u8(vorrq_u8(vld1q_u8(up + i), vld1q_u8(down + i)),
+        vorrq_u8(vorrq_u8(left(up + i), right(up + i)),
+          vorrq_u8(vorrq_u8(left(mid + i), right(mid + i)),
+            vorrq_u8(left(down + i), right(down + i)))));
+      uint8x16_t isolated = vbicq_u8(vld1q_u8(mid + i), neighbours);
+      vst1q_u8(out + i, vorrq_u8(vld1q_u8(out + i), isolated));
+    }
+#endif
+    for (; i < row_bytes; i++) {
+      auto left = [](const uint8_t* p) { return (uint8_t)((p[0] >> 1) | (p[-1] << 7)); };
+      auto right = [](const uint8_t* p) { return (uint8_t)((p[0] << 1) | (p[1] >> 7)); };
+      uint8_t neighbours = up[i] | down[i] | left(up + i) | right(up + i) | left(mid + i) |
+        right(mid + i) | left(down + i) | right(down + i);
+      out[i] |= (uint8_t)(mid[i] & ~neighbours);
+    }
+  }
+}
+
+void RemoveBorderNoise(ImageBuffer& buffer, int max_border) {
+  if (buffer.format != kImageBufferBitonal)
+    throw std::runtime_error("Unsupported image buffer format");
+  std::vector<int> row_black(buffer.height, 0), col_black(buffer.width, 0);
+  for (int y = 0; y < buffer.height; y++) {
+    for (int x = 0; x < buffer.width; x++) {
+      if (IsBlack(buffer, x, y)) {
+        row_black[y]++;
+        col_black[x]++;
+      }
+    }
+  }
+
+  // the innermost dark line within the border band of each edge
+  auto band = [max_border](const std::vector<int>& black, int length, bool reverse) {
+    int size = (int)black.size(), result = 0;
+    for (int i = 0; i < std::min(max_border, size); i++) {
+      if (black[reverse ? size - 1 - i : i] * 2 >= length)
+        result = i + 1;
+    }
+    return result;
+  };
+  int top = band(row_black, buffer.width, false);
+  int bottom = band(row_black, buffer.width, true);
+  int left = band(col_black, buffer.height, false);
+  int right = band(col_black, buffer.height, true);
+
+  for (int y = 0; y < buffer.height; y++) {
+    uint8_t* row = buffer.Row(y);
+    bool whole_row = y < top || y >= buffer.height - bottom;
+    for (int x = 0; x < buffer.width; x++) {
+      if (whole_row || x < left || x >= buffer.width - right)
+        row[x / 8] |= (uint8_t)(0x80 >> (x % 8));
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// PNG encoding
+////////////////////////////////////////////////////////////////////////////////////////////////////
+static void PutUInt32(std::vector<uint8_t>& out, uint32_t value) {
+  out.push_back((uint8_t)(value >> 24));
+  out.push_back((uint8_t)(value >> 16));
+  out.push_back((uint8_t)(value >> 8));
+  out.push_back((uint8_t)value);
+}
+
+static void PutChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data) {
+  PutUInt32(out, (uint32_t)data.size());
+  size_t start = out.size();
+  out.insert(out.end(), type, type + 4);
+  out.insert(out.end(), data.begin(), data.end());
+  PutUInt32(out, Crc32(&out[start], out.size() - start, 0));
+}
+
+// zlib stream of the filtered scanlines
+static void Deflate(const std::vector<uint8_t>& raw, std::vector<uint8_t>& out) {
+#ifdef PDFIX_SAMPLES_ZLIB
+  uLongf size = compressBound((uLong)raw.size());
+  out.resize(size);
+  if (compress2(out.data(), &size, raw.data(), (uLong)raw.size(), Z_DEFAULT_COMPRESSION) != Z_OK)
+    throw std::runtime_error("PNG compression failed");
+  out.resize(size);
+#else
+  // stored (uncompressed) deflate blocks
+  out = { 0x78, 0x01 };
+  size_t pos = 0;
+  do {
+    size_t len = std::min<size_t>(raw.size() - pos, 0xffff);
+    out.push_back(pos + len == raw.size() ? 1 : 0);
+    out.push_back((uint8_t)len);
+    out.push_back((uint8_t)(len >> 8));
+    out.push_back((uint8_t)~len);
+    out.push_back((uint8_t)(~len >> 8));
+    out.insert(out.end(), raw.begin() + pos, raw.begin() + pos + len);
+    pos += len;
+  } while (pos < raw.size());
+  uint32_t a = 1, b = 0;
+  for (auto byte : raw) {
+    a = (a + byte) % 65521;
+    b = (b + a) % 65521;
+  }
+  PutUInt32(out, (b << 16) | a);
+#endif
+}
+
+void EncodePng(const ImageBuffer& buffer, std::vector<uint8_t>& png) {
+  int bpp = 1;             // bytes per pixel for the filter
+  int bit_depth = 8;
+  int color_type = 0;      // grayscale
+  int row_size = buffer.width;
+  switch (buffer.format) {
+    case kImageBufferBgra: bpp = 3; color_type = 2; row_size = buffer.width * 3; break;
+    case kImageBufferGray: break;
+    case kImageBufferBitonal: bit_depth = 1; row_size = buffer.stride; break;
+  }
+
+  // scanlines with the Sub filter, bitonal rows are not filtered
+  std::vector<uint8_t> raw((size_t)(row_size + 1) * buffer.height);
+  std::vector<uint8_t> line(row_size);
+  for (int y = 0; y < buffer.height; y++) {
+    const uint8_t* src = buffer.Row(y);
+    if (buffer.format == kImageBufferBgra) {
+      for (int x = 0; x < buffer.width; x++) {
+        line[x * 3] = src[x * 4 + 2];
+        line[x * 3 + 1] = src[x * 4 + 1];
+        line[x * 3 + 2] = src[x * 4];
+      }
+    }
+    else
+      memcpy(line.data(), src, row_size);
+
+    uint8_t* dst = &raw[(size_t)y * (row_size + 1)];
+    if (buffer.format == kImageBufferBitonal) {
+      dst[0] = 0;
+      memcpy(dst + 1, line.data(), row_size);
+    }
+    else {
+      dst[0] = 1;
+      for (int i = 0; i < row_size; i++)
+        dst[i + 1] = (uint8_t)(line[i] - (i >= bpp ? line[i - bpp] : 0));
+    }
+  }
+
+  std::vector<uint8_t> ihdr;
+  PutUInt32(ihdr, buffer.width);
+  PutUInt32(ihdr, buffer.height);
+  ihdr.push_back((uint8_t)bit_depth);
+  ihdr.push_back((uint8_t)color_type);
+  ihdr.push_back(0);       // compression
+  ihdr.push_back(0);       // filter
+  ihdr.push_back(0);       // interlace
+
+  std::vector<uint8_t> idat;
+  Deflate(raw, idat);
+
+  static const uint8_t signature[] = { 0x89, 'P', 'N', 'G', 0x0d, 0x0a, 0x1a, 0x0a };
+  png.assign(signature, signature + sizeof(signature));
+  PutChunk(png, "IHDR", ihdr);
+  PutChunk(png, "IDAT", idat);
+  PutChunk(png, "IEND", std::vector<uint8_t>());
+}
+
+void SaveBytes(const std::vector<uint8_t>& data, const std::wstring& path) {
+  auto stream = GetPdfix()->CreateFileStream(path.c_str(), kPsTruncate);
+  if (!stream)
+    throw PdfixException();
+  bool written = data.empty() || stream->Write(0, data.data(), (int)data.size());
+  stream->Destroy();
+  if (!written)
+    throw PdfixException();
+}
+
+void SaveImageBuffer(const ImageBuffer& buffer, const std::wstring& path) {
+  std::vector<uint8_t> png;
+  EncodePng(buffer, png);
+  SaveBytes(png, path);
+}
@@ -0,0 +1,134 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// ImagePipeline.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/ImagePipeline.h"
+
+#include <string>
+#include <iostream>
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+ImagePipeline::ImagePipeline(
+  const PdfImageParams& img_params,           // output image params
+  size_t encode_threads,                      // number of encoder threads
+  size_t queue_size                           // max number of images waiting in each stage
+) : img_params_(img_params), encode_queue_(queue_size), write_queue_(queue_size) {
+  if (encode_threads == 0)
+    encode_threads = 1;
+  for (size_t i = 0; i < encode_threads; i++)
+    encoders_.emplace_back(&ImagePipeline::Encode, this);
+  writer_ = std::thread(&ImagePipeline::Write, this);
+}
+
+ImagePipeline::~ImagePipeline() {
+  if (!finished_) {
+    try {
+      Finish();
+    }
+    catch (...) {
+    }
+  }
+}
+
+void ImagePipeline::Push(PsImage* image, const PdfDevRect* dev_rect, const std::wstring& path) {
+  EncodeJob job;
+  job.image = image;
+  job.has_rect = dev_rect != nullptr;
+  if (dev_rect)
+    job.rect = *dev_rect;
+  job.path = path;
+  // the queue is closed after an error, drop the image
+  if (!encode_queue_.Push(job))
+    image->Destroy();
+}
+
+void ImagePipeline::Finish() {
+  if (finished_)
+    return;
+  finished_ = true;
+
+  // drain the encoders first, then the writer
+  encode_queue_.Close();
+  for (auto& encoder : encoders_)
+    encoder.join();
+  write_queue_.Close();
+  writer_.join();
+
+  if (error_)
+    std::rethrow_exception(error_);
+}
+
+// encoder stage - compress the image into memory
+void ImagePipeline::Encode() {
+  EncodeJob job;
+  while (encode_queue_.Pop(job)) {
+    auto image_deleter = [](PsImage* image) { image->Destroy(); };
+    std::unique_ptr<PsImage, decltype(image_deleter)> image(job.image, image_deleter);
+    if (HasError())
+      continue;
+
+    try {
+      auto stm_deleter = [](PsStream* stm) { stm->Destroy(); };
+      std::unique_ptr<PsStream, decltype(stm_deleter)> stm(GetPdfix()->CreateMemStream(),
+        stm_deleter);
+      if (!stm)
+        throw PdfixException();
+
+      bool saved = job.has_rect ?
+        image->SaveRectToStream(stm.get(), &img_params_, &job.rect) :
+        image->SaveToStream(stm.get(), &img_params_);
+      if (!saved)
+        throw PdfixException();
+
+      WriteJob write_job;
+      write_job.path = job.path;
+      write_job.data.resize(stm->GetSize());
+      if (!write_job.data.empty() &&
+        !stm->Read(0, &write_job.data[0], (int)write_job.data.size()))
+        throw PdfixException();
+
+      write_queue_.Push(std::move(write_job));
+    }
+    catch (...) {
+      SetError(std::current_exception());
+    }
+  }
+}
+
+// writer stage - save encoded images to disk
+void ImagePipeline::Write() {
+  WriteJob job;
+  while (write_queue_.Pop(job)) {
+    if (HasError())
+      continue;
+    try {
+      auto stream = GetPdfix()->CreateFileStream(job.path.c_str(), kPsTruncate);
+      if (!stream)
+        throw PdfixException();
+      bool written = job.data.empty() ||
+        stream->Write(0, &job.data[0], (int)job.data.size());
+      stream->Destroy();
+      if (!written)
+        throw PdfixException();
+    }
+    catch (...) {
+      SetError(std::current_exception());
+    }
+  }
+}
+
+void ImagePipeline::SetError(std::exception_ptr error) {
+  std::lock_guard<std::mutex> lock(error_mutex_);
+  if (!error_)
+    error_ = error;
+  // stop accepting new images, render workers must not block on a stalled pipeline
+  encode_queue_.Close();
+}
+
+bool ImagePipeline::HasError() {
+  std::lock_guard<std::mutex> lock(error_mutex_);
+  return error_ != nullptr;
+}
@@ -20,7 +20,8 @@ void MakeAccessible(
   std::pair<bool, std::wstring> language,  // document reading language
   std::pair<bool, std::wstring> title,     // document title
   const std::wstring& config_path,         // configuration file
-  const bool preflight                     // preflight document template before processing
+  const bool preflight,                    // preflight document template before processing
+  CancelToken* cancel                      // cancel token or nullptr
   ) {
   // initialize Pdfix
   if (!Pdfix_init(Pdfix_MODULE_NAME))
@@ -50,13 +51,17 @@ void MakeAccessible(
   if (preflight) {
     // add reference pages for preflight
     for (auto i = 0; i < doc->GetNumPages(); i++) {
-      if (!doc_template->AddPage(i, nullptr, nullptr))
+      if (!doc_template->AddPage(i, &CancelToken::CancelProc, cancel)) {
+        CancelToken::ThrowIfStopped(cancel);
         throw PdfixException();
+      }
     }
       
     // run document preflight
-    if (!doc_template->Update(nullptr, nullptr))
+    if (!doc_template->Update(&CancelToken::CancelProc, cancel)) {
+      CancelToken::ThrowIfStopped(cancel);
       throw PdfixException();
+    }
   }
 
   // convert to PDF/UA
@@ -65,8 +70,10 @@ void MakeAccessible(
   params.subset_fonts = 1;
   //params.accept_tags = 1;
  
-  if (!doc->MakeAccessible(&params, nullptr, nullptr))
+  if (!doc->MakeAccessible(&params, &CancelToken::CancelProc, cancel)) {
+    CancelToken::ThrowIfStopped(cancel);
     throw PdfixException();
+  }
 
   // set document language
   if (language.first)
@@ -0,0 +1,80 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// MappedFile.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/MappedFile.h"
+
+#include <string>
+#include <stdexcept>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "pdfixsdksamples/Utils.h"
+
+MappedFile::MappedFile(const std::wstring& path) {
+#ifdef _WIN32
+  HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+    FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    throw std::runtime_error("Mapped file open fail");
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size)) {
+    CloseHandle(file);
+    throw std::runtime_error("Mapped file open fail");
+  }
+  file_ = file;
+  size_ = (size_t)size.QuadPart;
+  // an empty file can't be mapped
+  if (size_ == 0)
+    return;
+  mapping_ = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping_)
+    data_ = (const uint8_t*)MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+  if (!data_) {
+    if (mapping_)
+      CloseHandle(mapping_);
+    CloseHandle(file);
+    throw std::runtime_error("Mapped file map fail");
+  }
+#else
+  int fd = open(ToUtf8(path).c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error("Mapped file open fail");
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    throw std::runtime_error("Mapped file open fail");
+  }
+  size_ = (size_t)st.st_size;
+  if (size_ != 0) {
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+      close(fd);
+      throw std::runtime_error("Mapped file map fail");
+    }
+    data_ = (const uint8_t*)data;
+  }
+  // the mapping stays valid after the descriptor is closed
+  close(fd);
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifdef _WIN32
+  if (data_)
+    UnmapViewOfFile(data_);
+  if (mapping_)
+    CloseHandle(mapping_);
+  if (file_)
+    CloseHandle(file_);
+#else
+  if (data_)
+    munmap((void*)data_, size_);
+#endif
+}
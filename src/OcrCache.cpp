@@ -0,0 +1,175 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// OcrCache.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/OcrCache.h"
+
+#include <string>
+#include <sstream>
+#include <memory>
+#include <thread>
+#include "pdfixsdksamples/Utils.h"
+#include "Pdfix.h"
+#include "OcrTesseract.h"
+
+using namespace PDFixSDK;
+namespace fs = std::filesystem;
+
+OcrRegionCache::OcrRegionCache(
+  OcrTesseract* ocr,                              // initialized OCR engine
+  PdfDoc* doc,                                    // document receiving the text
+  const std::wstring& language,                   // OCR language set on the engine
+  const std::wstring& data_path,                  // OCR data path set on the engine
+  const std::wstring& cache_dir                   // directory for OCR results, empty for none
+) : doc_(doc), dir_(cache_dir),
+    ocr_pdf_(GetPdfix()->CreateDoc(), [](PdfDoc* doc) { doc->Close(); }),
+    ocr_doc_(nullptr, [](TesseractDoc* ocr_doc) { ocr_doc->Close(); }) {
+  if (!ocr_pdf_)
+    throw PdfixException();
+  ocr_doc_.reset(ocr->OpenOcrDoc(ocr_pdf_.get()));
+  if (!ocr_doc_)
+    throw PdfixException();
+
+  // engine settings are the same for all regions, hash them once
+  int version[] = { ocr->GetVersionMajor(), ocr->GetVersionMinor(), ocr->GetVersionPatch() };
+  settings_hash_ = Fnv1aHash(version, sizeof(version));
+  settings_hash_ = Fnv1aHash(language.data(), language.size() * sizeof(wchar_t), settings_hash_);
+  // separator, language and data path must not run together
+  settings_hash_ = Fnv1aHash("|", 1, settings_hash_);
+  settings_hash_ = Fnv1aHash(data_path.data(), data_path.size() * sizeof(wchar_t),
+    settings_hash_);
+  engine_hash_ = settings_hash_;
+
+  if (!dir_.empty())
+    fs::create_directories(dir_);
+}
+
+void OcrRegionCache::SetPreprocess(const OcrPreprocess::Params& params) {
+  preprocess_enabled_ = true;
+  preprocess_ = params;
+  settings_hash_ = OcrPreprocess::HashParams(params, engine_hash_);
+}
+
+PdsStream* OcrRegionCache::GetTextLayer(
+  PsImage* image,                                 // rendered region
+  int image_width,                                // image width in pixels
+  int image_height,                               // image height in pixels
+  double width,                                   // region width in points
+  double height,                                  // region height in points
+  double zoom,                                    // zoom the region was rendered with
+  int page_rotate,                                // page rotation in quarter turns
+  const ImageBufferFormat color_mode,             // color mode of the image passed to OCR
+  CancelToken* cancel                             // cancel token or nullptr
+) {
+  // the key covers the pixels and everything that changes the text layer
+  ImageBuffer pixels;
+  ReadImagePixels(image, image_width, image_height, pixels);
+  uint64_t key = Fnv1aHash(pixels.data.data(), pixels.data.size(), settings_hash_);
+  int params[] = { image_width, image_height, page_rotate, (int)color_mode };
+  key = Fnv1aHash(params, sizeof(params), key);
+  double size[] = { width, height, zoom };
+  key = Fnv1aHash(size, sizeof(size), key);
+  pixels.data.clear();
+
+  auto it = text_layers_.find(key);
+  if (it != text_layers_.end()) {
+    hits_++;
+    return it->second;
+  }
+
+  auto name = HashToHex(key) + ".pdf";
+  if (!dir_.empty()) {
+    if (auto text_layer = Load(name)) {
+      disk_hits_++;
+      text_layers_[key] = text_layer;
+      return text_layer;
+    }
+  }
+  misses_++;
+
+  // recognize onto a scratch page of the region size
+  PdfRect region;
+  region.right = width;
+  region.top = height;
+  auto page_deleter = [](PdfPage* page) { page->Release(); };
+  std::unique_ptr<PdfPage, decltype(page_deleter)> ocr_page(
+    ocr_pdf_->CreatePage(-1, &region), page_deleter);
+  if (!ocr_page)
+    throw PdfixException();
+
+  // calculate PdfMatrix to position the recognized text on the region
+  double zoom_x = image_width / ((page_rotate % 2) ? height : width);
+  double zoom_y = image_height / ((page_rotate % 2) ? width : height);
+  PdfMatrix matrix;
+  PdfMatrixRotate(matrix, page_rotate * kPi / 2, false);
+  PdfMatrixScale(matrix, 1 / zoom_x, 1 / zoom_y, false);
+  switch (page_rotate) {
+    case 0: PdfMatrixTranslate(matrix, region.left, region.bottom, false); break;
+    case 1: PdfMatrixTranslate(matrix, region.right, region.bottom, false); break;
+    case 2: PdfMatrixTranslate(matrix, region.right, region.top, false); break;
+    case 3: PdfMatrixTranslate(matrix, region.left, region.top, false); break;
+  }
+
+  // the key was taken from the rendered pixels, the cleaned up ones go to OCR
+  if (preprocess_enabled_)
+    OcrPreprocess::PreprocessOcrImage(image, image_width, image_height, preprocess_, matrix);
+
+  if (!ocr_doc_->OcrImageToPage(image, &matrix, ocr_page.get(), &CancelToken::CancelProc,
+    cancel)) {
+    // drop the partial text, the scratch document must hold just the next recognized page
+    ocr_page.reset();
+    ocr_pdf_->DeletePages(0, 0, nullptr, nullptr);
+    CancelToken::ThrowIfStopped(cancel);
+    throw PdfixException();
+  }
+
+  auto text_layer = doc_->CreateXObjectFromPage(ocr_page.get());
+  if (!text_layer)
+    throw PdfixException();
+  ocr_page.reset();
+  // the scratch document holds just the recognized page now
+  if (!dir_.empty())
+    Store(name);
+  if (!ocr_pdf_->DeletePages(0, 0, nullptr, nullptr))
+    throw PdfixException();
+
+  text_layers_[key] = text_layer;
+  return text_layer;
+}
+
+// imports the stored text layer, returns nullptr when it's not on disk
+PdsStream* OcrRegionCache::Load(const std::string& name) {
+  auto path = dir_ / name;
+  std::error_code ec;
+  if (!fs::is_regular_file(path, ec))
+    return nullptr;
+
+  auto doc_deleter = [](PdfDoc* doc) { doc->Close(); };
+  std::unique_ptr<PdfDoc, decltype(doc_deleter)> result_doc(
+    GetPdfix()->OpenDoc(path.wstring().c_str(), L""), doc_deleter);
+  PdsStream* text_layer = nullptr;
+  if (result_doc && result_doc->GetNumPages() == 1) {
+    auto page_deleter = [](PdfPage* page) { page->Release(); };
+    std::unique_ptr<PdfPage, decltype(page_deleter)> page(result_doc->AcquirePage(0),
+      page_deleter);
+    if (page)
+      text_layer = doc_->CreateXObjectFromPage(page.get());
+  }
+  // the file was damaged outside of the cache, it's recognized and stored again
+  if (!text_layer) {
+    result_doc.reset();
+    fs::remove(path, ec);
+  }
+  return text_layer;
+}
+
+void OcrRegionCache::Store(const std::string& name) {
+  // write to a temporary file first, readers never see a partial result
+  std::stringstream tmp_name;
+  tmp_name << name << "." << std::this_thread::get_id() << ".tmp";
+  auto tmp_path = dir_ / tmp_name.str();
+  if (!ocr_pdf_->Save(tmp_path.wstring().c_str(), kSaveFull))
+    throw PdfixException();
+  fs::rename(tmp_path, dir_ / name);
+}
@@ -8,17 +8,17 @@
 #include <string>
 #include <iostream>
 #include <vector>
+#include <memory>
+#include <algorithm>
+#include <cmath>
+#include "pdfixsdksamples/Utils.h"
+#include "pdfixsdksamples/RenderPage.h"
+#include "pdfixsdksamples/OcrWithTesseract.h"
 #include "Pdfix.h"
 #include "OcrTesseract.h"
 
 using namespace PDFixSDK;
 
-#define kPi 3.1415926535897932384626433832795f
-
-extern void PdfMatrixRotate(PdfMatrix& m, double radian, bool prepend);
-extern void PdfMatrixScale(PdfMatrix& m, double sx, double sy, bool prepend);
-extern void PdfMatrixTranslate(PdfMatrix& m, double x, double y, bool prepend);
-
 void parse_page_element(PdeElement* elem, std::vector<PdfRect>& image_bbox_arr) {
   if (!elem)
     return;
@@ -34,13 +34,130 @@ void parse_page_element(PdeElement* elem, std::vector<PdfRect>& image_bbox_arr)
   }
 }
 
+void MergeDevRects(std::vector<PdfDevRect>& rects, int gap) {
+  auto touch = [gap](const PdfDevRect& a, const PdfDevRect& b) {
+    return a.left <= b.right + gap && b.left <= a.right + gap &&
+      a.top <= b.bottom + gap && b.top <= a.bottom + gap;
+  };
+  // a merged rectangle can touch rectangles checked before, repeat until nothing changes
+  bool merged = true;
+  while (merged) {
+    merged = false;
+    for (size_t i = 0; i < rects.size(); i++) {
+      for (size_t j = i + 1; j < rects.size();) {
+        if (touch(rects[i], rects[j])) {
+          rects[i].left = std::min(rects[i].left, rects[j].left);
+          rects[i].top = std::min(rects[i].top, rects[j].top);
+          rects[i].right = std::max(rects[i].right, rects[j].right);
+          rects[i].bottom = std::max(rects[i].bottom, rects[j].bottom);
+          rects.erase(rects.begin() + j);
+          merged = true;
+        }
+        else {
+          j++;
+        }
+      }
+    }
+  }
+}
+
+int OcrPageImages(
+  OcrRegionCache& cache,                          // OCR results of the document
+  PdfPage* page,                                  // page to recognize
+  const double zoom,                              // max zoom to control page rendering quality
+  const PdfRotate rotate,                         // page rotation to be applied
+  const ImageBufferFormat color_mode,             // color mode of the image passed to OCR
+  CancelToken* cancel                             // cancel token or nullptr
+) {
+  // collect page images
+  std::vector<PdfRect> image_bbox_arr;
+
+  // find images on the page and collect bounding boxes to ocr
+  PdePageMap* page_map = page->AcquirePageMap(&CancelToken::CancelProc, cancel);
+  if (!page_map) {
+    CancelToken::ThrowIfStopped(cancel);
+    throw PdfixException();
+  }
+    
+  PdeElement* elem = page_map->GetElement();
+  parse_page_element(elem, image_bbox_arr);
+  
+  page_map->Release();
+  if (image_bbox_arr.empty())
+    return 0;
+
+  // merge overlapping and adjacent images in the device space of the render
+  auto page_view_deleter = [](PdfPageView* page_view) { page_view->Release(); };
+  std::unique_ptr<PdfPageView, decltype(page_view_deleter)> page_view(
+    page->AcquirePageView(zoom, rotate), page_view_deleter);
+  if (!page_view)
+    throw PdfixException();
+
+  std::vector<PdfDevRect> regions;
+  for (auto& bbox : image_bbox_arr) {
+    PdfDevRect dev_rect;
+    page_view->RectToDevice(&bbox, &dev_rect);
+    dev_rect.left = std::max(0, dev_rect.left);
+    dev_rect.top = std::max(0, dev_rect.top);
+    dev_rect.right = std::min(page_view->GetDeviceWidth(), dev_rect.right);
+    dev_rect.bottom = std::min(page_view->GetDeviceHeight(), dev_rect.bottom);
+    if (dev_rect.right > dev_rect.left && dev_rect.bottom > dev_rect.top)
+      regions.push_back(dev_rect);
+  }
+  MergeDevRects(regions, (int)std::ceil(zoom * 2));
+
+  auto page_rotate = ((page->GetRotate() / 90) % 4);
+  auto content = page->GetContent();
+  for (auto& dev_rect : regions) {
+    PdfRect bbox;
+    page_view->RectToPage(&dev_rect, &bbox);
+
+    // regions are rendered at the native resolution of their images up to zoom
+    double region_zoom = GetOcrZoom(page, bbox, zoom);
+    PdfDevRect region_rect = dev_rect;
+    if (region_zoom != zoom) {
+      std::unique_ptr<PdfPageView, decltype(page_view_deleter)> region_view(
+        page->AcquirePageView(region_zoom, rotate), page_view_deleter);
+      if (!region_view)
+        throw PdfixException();
+      region_view->RectToDevice(&bbox, &region_rect);
+      region_rect.left = std::max(0, region_rect.left);
+      region_rect.top = std::max(0, region_rect.top);
+      region_rect.right = std::min(region_view->GetDeviceWidth(), region_rect.right);
+      region_rect.bottom = std::min(region_view->GetDeviceHeight(), region_rect.bottom);
+    }
+
+    // render just the region
+    int width = 0, height = 0;
+    auto image_deleter = [](PsImage* image) { image->Destroy(); };
+    std::unique_ptr<PsImage, decltype(image_deleter)> image(RenderPageImage(page, region_zoom,
+      rotate, region_rect, GetOcrRenderFlags(color_mode), width, height, cancel), image_deleter);
+
+    auto text_layer = cache.GetTextLayer(image.get(), width, height, bbox.right - bbox.left,
+      bbox.top - bbox.bottom, region_zoom, page_rotate, color_mode, cancel);
+
+    // place the text layer over the region
+    PdfMatrix matrix;
+    PdfMatrixTranslate(matrix, bbox.left, bbox.bottom, false);
+    if (!content->AddNewForm(-1, text_layer, &matrix))
+      throw PdfixException();
+  }
+  if (!page->SetContent())
+    throw PdfixException();
+  return (int)regions.size();
+}
+
 void OcrPageImagesWithTesseract(
   const std::wstring& open_path,                  // source PDF document
   const std::wstring& save_path,                  // searchable PDF document
   const std::wstring& data_path,                  // path to OCR data
   const std::wstring& language,                   // default OCR language
   const double zoom,                              // zoom to control page rendering quality
-  const PdfRotate rotate                          // page rotation to be applied
+  const PdfRotate rotate,                         // page rotation to be applied
+  const ImageBufferFormat color_mode,             // color mode of the image passed to OCR
+  CancelToken* cancel,                            // cancel token or nullptr
+  const std::wstring& cache_dir,                  // directory for OCR results, empty for none
+  const OcrPreprocess::Params* preprocess         // preprocessing steps or nullptr
 ) {
   // initialize Pdfix
   if (!Pdfix_init(Pdfix_MODULE_NAME))
@@ -64,79 +181,32 @@ void OcrPageImagesWithTesseract(
   PdfDoc* doc = pdfix->OpenDoc(open_path.c_str(), L"");
   if (!doc)
     throw PdfixException();
-  
-  // collect page images
-  std::vector<PdfRect> image_bbox_arr;
-  
-  PdfPage* page = doc->AcquirePage(0);
-  if (!page)
-    throw PdfixException();
-
-  // find images on the page and collect bounding boxes to ocr
-  PdePageMap* page_map = page->AcquirePageMap(nullptr, nullptr);
-  if (!page_map)
-    throw PdfixException();
-    
-  PdeElement* elem = page_map->GetElement();
-  parse_page_element(elem, image_bbox_arr);
-  
-  page_map->Release();
 
   // setup the ocr engine
   ocr->SetLanguage(language.c_str());
   ocr->SetDataPath(data_path.c_str());
 
-  TesseractDoc* ocr_doc = ocr->OpenOcrDoc(doc);
-  if (!ocr_doc)
-    throw PdfixException();
-  
-  // prepare page rendering matrix
-  PdfPageView* page_view = page->AcquirePageView(zoom, rotate);
-  
-  // run ocr on each image bbox
-  for (auto& bbox : image_bbox_arr) {
-    // render page to image
-    PdfDevRect dev_rect;
-    page_view->RectToDevice(&bbox, &dev_rect);
-    int width = dev_rect.right - dev_rect.left;
-    int height = dev_rect.bottom - dev_rect.top;
-    
-    PsImage* image = pdfix->CreateImage(width, height, kImageDIBFormatArgb);
-
-    // render portion of the page - the image
-    PdfPageRenderParams render_params;
-    page_view->GetDeviceMatrix(&render_params.matrix);
-    render_params.image = image;
-    render_params.clip_box = bbox;
-    if (!page->DrawContent(&render_params, nullptr, nullptr))
-      throw PdfixException();
-    
-    // calculate PdfMatrix to position the recognized text on the page
-    auto rotate = ((page->GetRotate() / 90) % 4);
-    PdfMatrix matrix;
-    PdfMatrixRotate(matrix, rotate * kPi / 2, false);
-    PdfMatrixScale(matrix, 1/zoom, 1/zoom, false);
-    switch (rotate) {
-      case 0: PdfMatrixTranslate(matrix, bbox.left, bbox.bottom, false); break;
-      case 1: PdfMatrixTranslate(matrix, bbox.right, bbox.bottom, false); break;
-      case 2: PdfMatrixTranslate(matrix, bbox.right, bbox.top, false); break;
-      case 3: PdfMatrixTranslate(matrix, bbox.left, bbox.top, false); break;
+  int num_regions = 0;
+  {
+    OcrRegionCache cache(ocr, doc, language, data_path, cache_dir);
+    if (preprocess)
+      cache.SetPreprocess(*preprocess);
+    for (int i = 0; i < doc->GetNumPages(); i++) {
+      auto page_deleter = [](PdfPage* page) { page->Release(); };
+      std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(i), page_deleter);
+      if (!page)
+        throw PdfixException();
+      num_regions += OcrPageImages(cache, page.get(), zoom, rotate, color_mode, cancel);
     }
-    
-    if (!ocr_doc->OcrImageToPage(image, &matrix, page, nullptr, nullptr))
-      throw PdfixException();
-    
-    image->Destroy();
+    std::cout << "Image regions: " << num_regions << ", recognized: " << cache.GetMisses()
+      << ", reused: " << cache.GetHits() << ", from disk: " << cache.GetDiskHits() << std::endl;
   }
-  
-  page->Release();
 
   if (!doc->Save(save_path.c_str(), kSaveFull))
     throw PdfixException();
 
-  ocr_doc->Close();
   ocr->Destroy();
 
   doc->Close();
   pdfix->Destroy();
-}
\ No newline at end of file
+}
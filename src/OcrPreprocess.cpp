@@ -0,0 +1,166 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// OcrPreprocess.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/OcrPreprocess.h"
+
+#include <string>
+#include <iostream>
+#include <memory>
+#include <algorithm>
+#include <cmath>
+#include "pdfixsdksamples/Utils.h"
+#include "pdfixsdksamples/OcrWithTesseract.h"
+#include "Pdfix.h"
+#include "OcrTesseract.h"
+
+using namespace PDFixSDK;
+
+namespace OcrPreprocess {
+
+  uint64_t HashParams(const Params& params, uint64_t hash) {
+    // field by field, the struct has padding
+    int ints[] = { (int)params.binarization, params.window, params.deskew, params.despeckle,
+      params.remove_border, params.max_border };
+    hash = Fnv1aHash(ints, sizeof(ints), hash);
+    double doubles[] = { params.k, params.max_skew };
+    return Fnv1aHash(doubles, sizeof(doubles), hash);
+  }
+
+  double PreprocessImage(
+    const ImageBuffer& gray,                    // kImageBufferGray page or region
+    const Params& params,                       // preprocessing steps
+    ImageBuffer& output                         // preprocessed image
+  ) {
+    int width = gray.width, height = gray.height;
+    ImageBuffer bitonal;
+    switch (params.binarization) {
+      case kBinarizeOtsu:
+        ThresholdGlobal(gray, bitonal, OtsuThreshold(gray));
+        break;
+      case kBinarizeSauvola:
+        ThresholdSauvola(gray, bitonal,
+          params.window > 0 ? params.window : std::max(15, width / 40), params.k);
+        break;
+      default: ;
+    }
+
+    if (!bitonal.data.empty()) {
+      // border first, a dark band would hold specks together and bias the skew
+      if (params.remove_border)
+        RemoveBorderNoise(bitonal, params.max_border > 0 ? params.max_border :
+          std::min(width, height) / 20);
+      if (params.despeckle)
+        Despeckle(bitonal);
+    }
+
+    output = bitonal.data.empty() ? gray : std::move(bitonal);
+    double angle = 0;
+    if (params.deskew) {
+      if (output.format == kImageBufferBitonal) {
+        angle = EstimateSkew(output, params.max_skew, 0.1);
+      }
+      else {
+        ImageBuffer estimate;
+        ThresholdGlobal(gray, estimate, OtsuThreshold(gray));
+        angle = EstimateSkew(estimate, params.max_skew, 0.1);
+      }
+
+      // below 0.1 degree the lines are straight enough for OCR
+      if (std::fabs(angle) < 0.1)
+        return 0;
+      ImageBuffer rotated;
+      RotateImageBuffer(output, rotated, angle);
+      output = std::move(rotated);
+    }
+    return angle;
+  }
+
+  void PreprocessOcrImage(
+    PsImage* image,                             // rendered page or region
+    int width,                                  // image width in pixels
+    int height,                                 // image height in pixels
+    const Params& params,                       // preprocessing steps
+    PdfMatrix& matrix                           // OCR image to page matrix
+  ) {
+    ImageBuffer gray, output;
+    {
+      ImageBuffer pixels;
+      ReadImagePixels(image, width, height, pixels);
+      ConvertToGray(pixels, gray);
+    }
+    double angle = PreprocessImage(gray, params, output);
+    gray.data.clear();
+    WriteImagePixels(output, image);
+
+    if (angle != 0) {
+      // the image space of OcrImageToPage has its origin at the bottom-left corner, the rotation
+      // of the buffer rows is reversed there
+      PdfMatrix deskew;
+      PdfMatrixTranslate(deskew, -width / 2., -height / 2., false);
+      PdfMatrixRotate(deskew, -angle * kPi / 180, false);
+      PdfMatrixTranslate(deskew, width / 2., height / 2., false);
+      PdfMatrixConcat(matrix, deskew, true);
+    }
+  }
+
+  void Run(
+    const std::wstring& open_path,              // source PDF document
+    const std::wstring& save_path,              // searchable PDF document
+    const std::wstring& data_path,              // path to OCR data
+    const std::wstring& language,               // default OCR language
+    double zoom,                                // max page zoom level for rendering
+    PdfRotate rotate,                           // page rotation
+    const Params& params,                       // preprocessing steps
+    CancelToken* cancel                         // cancel token or nullptr
+  ) {
+    // initialize Pdfix
+    if (!Pdfix_init(Pdfix_MODULE_NAME))
+      throw std::runtime_error("Pdfix initialization fail");
+
+    Pdfix* pdfix = GetPdfix();
+    if (!pdfix)
+      throw std::runtime_error("GetPdfix fail");
+
+    // initialize OcrTesseract
+    if (!OcrTesseract_init(OcrTesseract_MODULE_NAME))
+      throw std::runtime_error("OcrTesseract_init fail");
+
+    OcrTesseract* ocr = GetOcrTesseract();
+    if (!ocr)
+      throw std::runtime_error("GetOcrTesseract fail");
+
+    if (!ocr->Initialize(pdfix))
+      throw PdfixException();
+
+    PdfDoc* doc = pdfix->OpenDoc(open_path.c_str(), L"");
+    if (!doc)
+      throw PdfixException();
+
+    ocr->SetLanguage(language.c_str());
+    ocr->SetDataPath(data_path.c_str());
+
+    TesseractDoc* ocr_doc = ocr->OpenOcrDoc(doc);
+    if (!ocr_doc)
+      throw PdfixException();
+
+    for (int i = 0; i < doc->GetNumPages(); i++) {
+      auto page_deleter = [](PdfPage* page) { page->Release(); };
+      std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(i), page_deleter);
+      if (!page)
+        throw PdfixException();
+      // preprocessing works on gray pixels, they are rendered natively
+      OcrPage(ocr_doc, page.get(), page.get(), zoom, rotate, kImageBufferGray, cancel, &params);
+    }
+
+    if (!doc->Save(save_path.c_str(), kSaveFull))
+      throw PdfixException();
+
+    ocr_doc->Close();
+    ocr->Destroy();
+
+    doc->Close();
+    pdfix->Destroy();
+  }
+}
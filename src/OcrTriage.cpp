@@ -0,0 +1,139 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// OcrTriage.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/OcrTriage.h"
+
+#include <string>
+#include <iostream>
+#include <memory>
+#include "pdfixsdksamples/RenderPage.h"
+#include "pdfixsdksamples/OcrWithTesseract.h"
+#include "pdfixsdksamples/OcrPageImagesWithTesseract.h"
+#include "Pdfix.h"
+#include "OcrTesseract.h"
+
+using namespace PDFixSDK;
+
+namespace OcrTriage {
+
+  const char* GetPageContentClassName(PageContentClass page_class) {
+    switch (page_class) {
+      case kPageBlank: return "blank";
+      case kPageBornDigital: return "born-digital";
+      case kPageImageOnly: return "image-only";
+      case kPageMixed: return "mixed";
+    }
+    return "unknown";
+  }
+
+  bool IsPageBlank(
+    PdfPage* page,                              // page to check
+    double zoom,                                // render zoom, e.g. 0.125 for 9 dpi
+    CancelToken* cancel                         // cancel token or nullptr
+  ) {
+    ImageBuffer pixels;
+    RenderPagePixels(page, zoom, kRotate0, PdfDevRect(), kImageBufferGray, pixels, cancel);
+
+    // small text blurs into light gray at this resolution, a few dark pixels are scanner noise
+    size_t dark = 0;
+    for (int y = 0; y < pixels.height; y++) {
+      const uint8_t* row = pixels.Row(y);
+      for (int x = 0; x < pixels.width; x++)
+        dark += row[x] < 230;
+    }
+    return dark <= (size_t)pixels.width * pixels.height / 1000;
+  }
+
+  PageContentClass ClassifyPage(
+    PdfPage* page,                              // page to classify
+    CancelToken* cancel                         // cancel token or nullptr
+  ) {
+    auto flags = page->GetContentFlags();
+    bool has_text = (flags & kContentText) != 0;
+    bool has_image = (flags & kContentImage) != 0;
+    // invisible text only is a text layer of a previous OCR run
+    bool ocr_text = has_text && (flags & kContentTextTransparent) != 0 &&
+      (flags & (kContentTextFill | kContentTextStroke)) == 0;
+    if (has_text)
+      return has_image && !ocr_text ? kPageMixed : kPageBornDigital;
+    // vector art and forms can hold outlined text too, only an empty render means no OCR
+    return IsPageBlank(page, 0.125, cancel) ? kPageBlank : kPageImageOnly;
+  }
+
+  void Run(
+    const std::wstring& open_path,              // source PDF document
+    const std::wstring& save_path,              // searchable PDF document
+    const std::wstring& data_path,              // path to OCR data
+    const std::wstring& language,               // default OCR language
+    double zoom,                                // page zoom level for rendering
+    PdfRotate rotate,                           // page rotation
+    ImageBufferFormat color_mode,               // color mode of the image passed to OCR
+    CancelToken* cancel                         // cancel token or nullptr
+  ) {
+    // initialize Pdfix
+    if (!Pdfix_init(Pdfix_MODULE_NAME))
+      throw std::runtime_error("Pdfix initialization fail");
+
+    Pdfix* pdfix = GetPdfix();
+    if (!pdfix)
+      throw std::runtime_error("GetPdfix fail");
+
+    // initialize OcrTesseract
+    if (!OcrTesseract_init(OcrTesseract_MODULE_NAME))
+      throw std::runtime_error("OcrTesseract_init fail");
+
+    OcrTesseract* ocr = GetOcrTesseract();
+    if (!ocr)
+      throw std::runtime_error("GetOcrTesseract fail");
+
+    if (!ocr->Initialize(pdfix))
+      throw PdfixException();
+
+    PdfDoc* doc = pdfix->OpenDoc(open_path.c_str(), L"");
+    if (!doc)
+      throw PdfixException();
+
+    ocr->SetLanguage(language.c_str());
+    ocr->SetDataPath(data_path.c_str());
+
+    TesseractDoc* ocr_doc = ocr->OpenOcrDoc(doc);
+    if (!ocr_doc)
+      throw PdfixException();
+    OcrRegionCache region_cache(ocr, doc, language, data_path, L"");
+
+    int counts[4] = { 0, 0, 0, 0 };
+    for (int i = 0; i < doc->GetNumPages(); i++) {
+      auto page_deleter = [](PdfPage* page) { page->Release(); };
+      std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(i), page_deleter);
+      if (!page)
+        throw PdfixException();
+
+      auto page_class = ClassifyPage(page.get(), cancel);
+      counts[page_class]++;
+      std::cout << "Page " << (i + 1) << ": " << GetPageContentClassName(page_class) << std::endl;
+      switch (page_class) {
+        case kPageImageOnly:
+          OcrPage(ocr_doc, page.get(), page.get(), zoom, rotate, color_mode, cancel);
+          break;
+        case kPageMixed:
+          OcrPageImages(region_cache, page.get(), zoom, rotate, color_mode, cancel);
+          break;
+        default: ;
+      }
+    }
+    std::cout << "OCR triage: " << counts[kPageImageOnly] << " image-only, " << counts[kPageMixed]
+      << " mixed, " << counts[kPageBornDigital] << " born-digital, " << counts[kPageBlank]
+      << " blank" << std::endl;
+
+    if (!doc->Save(save_path.c_str(), kSaveFull))
+      throw PdfixException();
+
+    ocr_doc->Close();
+    ocr->Destroy();
+
+    doc->Close();
+    pdfix->Destroy();
+  }
+}
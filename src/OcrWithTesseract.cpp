@@ -7,28 +7,194 @@
 
 #include <string>
 #include <iostream>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <cmath>
+#include <exception>
 #include "pdfixsdksamples/Utils.h"
+#include "pdfixsdksamples/RenderPage.h"
 #include "Pdfix.h"
 #include "OcrTesseract.h"
 
 using namespace PDFixSDK;
 
-void OcrWithTesseract(
-  const std::wstring& open_path,                  // source PDF document
-  const std::wstring& save_path,                  // searchable PDF document
-  const std::wstring& data_path,                  // path to OCR data
-  const std::wstring& language,                   // default OCR language
-  const double zoom,                              // page zoom level for rendering to control image processing quality
-  const PdfRotate rotate                          // page rotation
+// native zoom of the images covering at least half of the area, nested forms included
+static void GetImageZoom(PdsPageObject* object, const PdfRect& area, double& native_zoom) {
+  if (!object)
+    return;
+  if (object->GetObjectType() == kPdsPageForm) {
+    auto content_deleter = [](PdsContent* content) { content->Release(); };
+    std::unique_ptr<PdsContent, decltype(content_deleter)> content(
+      ((PdsForm*)object)->AcquireContent(), content_deleter);
+    if (!content)
+      throw PdfixException();
+    for (int i = 0; i < content->GetNumObjects(); i++)
+      GetImageZoom(content->GetObject(i), area, native_zoom);
+    return;
+  }
+  if (object->GetObjectType() != kPdsPageImage)
+    return;
+
+  PdsImage* image = (PdsImage*)object;
+  double area_size = (area.right - area.left) * (area.top - area.bottom);
+  PdfRect bbox = image->GetBBox();
+  double cover_width = std::min(bbox.right, area.right) - std::max(bbox.left, area.left);
+  double cover_height = std::min(bbox.top, area.top) - std::max(bbox.bottom, area.bottom);
+  if (cover_width <= 0 || cover_height <= 0 || cover_width * cover_height * 2 < area_size)
+    return;
+  auto stm = image->GetDataStm();
+  auto dict = stm ? stm->GetStreamDict() : nullptr;
+  if (!dict)
+    return;
+  double pixels = (double)dict->GetInteger(L"Width", 0) * dict->GetInteger(L"Height", 0);
+  double points = (bbox.right - bbox.left) * (bbox.top - bbox.bottom);
+  // pixels per point, the area ratio does not depend on the image rotation
+  if (pixels > 0 && points > 0)
+    native_zoom = std::max(native_zoom, std::sqrt(pixels / points));
+}
+
+double GetOcrZoom(
+  PdfPage* page,                                  // page to recognize
+  const PdfRect& area,                            // page area to recognize
+  const double max_zoom,                          // zoom of the target resolution
+  const double min_zoom                           // zoom floor for low resolution images
 ) {
-  // initialize Pdfix
-  if (!Pdfix_init(Pdfix_MODULE_NAME))
-    throw std::runtime_error("Pdfix initialization fail");
+  auto content = page->GetContent();
+  if (!content)
+    throw PdfixException();
+  double native_zoom = 0;
+  for (int i = 0; i < content->GetNumObjects(); i++)
+    GetImageZoom(content->GetObject(i), area, native_zoom);
+  if (native_zoom <= 0)
+    return max_zoom;
+  // scans are not upsampled beyond their resolution unless the caller opts in with min_zoom
+  return std::min(std::max(native_zoom, min_zoom), max_zoom);
+}
 
-  Pdfix* pdfix = GetPdfix();
-  if (!pdfix)
-    throw std::runtime_error("GetPdfix fail");
+int GetOcrRenderFlags(const ImageBufferFormat color_mode) {
+  switch (color_mode) {
+    case kImageBufferBgra: return kRenderAnnot;
+    case kImageBufferGray: return kRenderAnnot | kRenderGrayscale;
+    default: throw std::runtime_error("Unsupported OCR color mode");
+  }
+}
 
+void OcrPage(
+  TesseractDoc* ocr_doc,                          // OCR engine of ocr_page document
+  PdfPage* page,                                  // page to recognize
+  PdfPage* ocr_page,                              // page receiving the text
+  const double max_zoom,                          // max page zoom level for rendering
+  const PdfRotate rotate,                         // page rotation
+  const ImageBufferFormat color_mode,             // color mode of the image passed to OCR
+  CancelToken* cancel,                            // cancel token or nullptr
+  const OcrPreprocess::Params* preprocess         // preprocessing steps or nullptr
+) {
+  PdfRect crop_box;
+  page->GetCropBox(&crop_box);
+  double zoom = GetOcrZoom(page, crop_box, max_zoom);
+
+  // draw page to an image, gray pixels are rendered natively
+  int width = 0, height = 0;
+  auto image_deleter = [](PsImage* image) { image->Destroy(); };
+  std::unique_ptr<PsImage, decltype(image_deleter)> image(RenderPageImage(page, zoom,
+    rotate, PdfDevRect(), GetOcrRenderFlags(color_mode), width, height, cancel), image_deleter);
+
+  // calculate PdfMatrix to position the recognized text on the page
+  auto page_rotate = ((page->GetRotate() / 90) % 4);
+  PdfMatrix matrix;
+  PdfMatrixRotate(matrix, page_rotate * kPi / 2, false);
+  PdfMatrixScale(matrix, 1/zoom, 1/zoom, false);
+  switch (page_rotate) {
+    case 0: PdfMatrixTranslate(matrix, crop_box.left, crop_box.bottom, false); break;
+    case 1: PdfMatrixTranslate(matrix, crop_box.right, crop_box.bottom, false); break;
+    case 2: PdfMatrixTranslate(matrix, crop_box.right, crop_box.top, false); break;
+    case 3: PdfMatrixTranslate(matrix, crop_box.left, crop_box.top, false); break;
+  }
+
+  if (preprocess)
+    OcrPreprocess::PreprocessOcrImage(image.get(), width, height, *preprocess, matrix);
+
+  if (!ocr_doc->OcrImageToPage(image.get(), &matrix, ocr_page, &CancelToken::CancelProc,
+    cancel)) {
+    CancelToken::ThrowIfStopped(cancel);
+    throw PdfixException();
+  }
+}
+
+void OcrPageCached(
+  OcrRegionCache& cache,                          // OCR results
+  PdfPage* page,                                  // page to recognize
+  const double max_zoom,                          // max page zoom level for rendering
+  const PdfRotate rotate,                         // page rotation
+  const ImageBufferFormat color_mode,             // color mode of the image passed to OCR
+  CancelToken* cancel                             // cancel token or nullptr
+) {
+  PdfRect crop_box;
+  page->GetCropBox(&crop_box);
+  double zoom = GetOcrZoom(page, crop_box, max_zoom);
+
+  int width = 0, height = 0;
+  auto image_deleter = [](PsImage* image) { image->Destroy(); };
+  std::unique_ptr<PsImage, decltype(image_deleter)> image(RenderPageImage(page, zoom,
+    rotate, PdfDevRect(), GetOcrRenderFlags(color_mode), width, height, cancel), image_deleter);
+
+  auto page_rotate = ((page->GetRotate() / 90) % 4);
+  auto text_layer = cache.GetTextLayer(image.get(), width, height, crop_box.right - crop_box.left,
+    crop_box.top - crop_box.bottom, zoom, page_rotate, color_mode, cancel);
+
+  // the text layer is in the crop box space
+  PdfMatrix matrix;
+  PdfMatrixTranslate(matrix, crop_box.left, crop_box.bottom, false);
+  if (!page->GetContent()->AddNewForm(-1, text_layer, &matrix))
+    throw PdfixException();
+  if (!page->SetContent())
+    throw PdfixException();
+}
+
+// returns false when the page was skipped over its time budget, the page is recognized through
+// the cache when there is one
+static bool OcrPageWithBudget(TesseractDoc* ocr_doc, OcrRegionCache* cache, PdfPage* page,
+  PdfPage* ocr_page, const double zoom, const PdfRotate rotate,
+  const ImageBufferFormat color_mode, CancelToken* cancel, const int page_timeout,
+  const OcrPreprocess::Params* preprocess) {
+  // the text of a recognition stopped half way is removed again, a skipped page keeps just its
+  // original content
+  auto target = cache ? page : ocr_page;
+  auto content = target->GetContent();
+  if (!content)
+    throw PdfixException();
+  int num_objects = content->GetNumObjects();
+
+  CancelToken page_cancel(cancel, page_timeout);
+  try {
+    if (cache)
+      OcrPageCached(*cache, page, zoom, rotate, color_mode, &page_cancel);
+    else
+      OcrPage(ocr_doc, page, ocr_page, zoom, rotate, color_mode, &page_cancel, preprocess);
+    return true;
+  }
+  catch (CancelException& e) {
+    // the whole job stops when the parent token stopped, only the page is skipped otherwise
+    if (!e.IsExpired() || (cancel && cancel->IsStopped()))
+      throw;
+    if (content->GetNumObjects() > num_objects) {
+      for (int i = content->GetNumObjects() - 1; i >= num_objects; i--) {
+        if (!content->RemoveObject(content->GetObject(i)))
+          throw PdfixException();
+      }
+      if (!target->SetContent())
+        throw PdfixException();
+    }
+    return false;
+  }
+}
+
+static OcrTesseract* InitializeOcr(Pdfix* pdfix, const std::wstring& data_path,
+  const std::wstring& language) {
   // initialize OcrTesseract
   if (!OcrTesseract_init(OcrTesseract_MODULE_NAME))
     throw std::runtime_error("OcrTesseract_init fail");
@@ -44,55 +210,65 @@ void OcrWithTesseract(
   if (!ocr->Initialize(pdfix))
     throw PdfixException();
 
+  ocr->SetLanguage(language.c_str());
+  ocr->SetDataPath(data_path.c_str());
+  return ocr;
+}
+
+std::vector<int> OcrWithTesseract(
+  const std::wstring& open_path,                  // source PDF document
+  const std::wstring& save_path,                  // searchable PDF document
+  const std::wstring& data_path,                  // path to OCR data
+  const std::wstring& language,                   // default OCR language
+  const double zoom,                              // page zoom level for rendering to control image processing quality
+  const PdfRotate rotate,                         // page rotation
+  const ImageBufferFormat color_mode,             // color mode of the image passed to OCR
+  CancelToken* cancel,                            // cancel token of the whole job or nullptr
+  const int page_timeout,                         // time budget per page in milliseconds, 0 for none
+  const std::wstring& cache_dir,                  // directory for OCR results, empty for none
+  const OcrPreprocess::Params* preprocess         // preprocessing steps or nullptr
+) {
+  // initialize Pdfix
+  if (!Pdfix_init(Pdfix_MODULE_NAME))
+    throw std::runtime_error("Pdfix initialization fail");
+
+  Pdfix* pdfix = GetPdfix();
+  if (!pdfix)
+    throw std::runtime_error("GetPdfix fail");
+
+  auto ocr = InitializeOcr(pdfix, data_path, language);
+
   PdfDoc* doc = pdfix->OpenDoc(open_path.c_str(), L"");
   if (!doc)
     throw PdfixException();
 
-  ocr->SetLanguage(language.c_str());
-  ocr->SetDataPath(data_path.c_str());
-
   TesseractDoc* ocr_doc = ocr->OpenOcrDoc(doc);
   if (!ocr_doc)
     throw PdfixException();
+
+  std::unique_ptr<OcrRegionCache> cache;
+  if (!cache_dir.empty())
+    cache.reset(new OcrRegionCache(ocr, doc, language, data_path, cache_dir));
+  if (cache && preprocess)
+    cache->SetPreprocess(*preprocess);
   
-  // ocr each page in the document
+  // ocr each page in the document, each page gets its own time budget
+  std::vector<int> skipped;
   for (int i = 0; i < doc->GetNumPages(); i++) {
-    PdfPage* page = doc->AcquirePage(i);
-    
-    PdfRect crop_box;
-    page->GetCropBox(&crop_box);
-    
-    PdfPageView* page_view = page->AcquirePageView(zoom, rotate);
-    
-    // draw page to an image
-    PsImage* image = pdfix->CreateImage(page_view->GetDeviceWidth(), page_view->GetDeviceHeight(),
-      kImageDIBFormatArgb);
-    if (!image)
-      throw PdfixException();
-    
-    PdfPageRenderParams params;
-    params.image = image;
-    page_view->GetDeviceMatrix(&params.matrix);
-    
-    if (!page->DrawContent(&params, nullptr, nullptr))
+    auto page_deleter = [](PdfPage* page) { page->Release(); };
+    std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(i), page_deleter);
+    if (!page)
       throw PdfixException();
-    
-    // calculate PdfMatrix to position the recognized text on the page
-    auto rotate = ((page->GetRotate() / 90) % 4);
-    PdfMatrix matrix;
-    PdfMatrixRotate(matrix, rotate * kPi / 2, false);
-    PdfMatrixScale(matrix, 1/zoom, 1/zoom, false);
-    switch (rotate) {
-      case 0: PdfMatrixTranslate(matrix, crop_box.left, crop_box.bottom, false); break;
-      case 1: PdfMatrixTranslate(matrix, crop_box.right, crop_box.bottom, false); break;
-      case 2: PdfMatrixTranslate(matrix, crop_box.right, crop_box.top, false); break;
-      case 3: PdfMatrixTranslate(matrix, crop_box.left, crop_box.top, false); break;
+    if (!OcrPageWithBudget(ocr_doc, cache.get(), page.get(), page.get(), zoom, rotate, color_mode,
+      cancel, page_timeout, preprocess)) {
+      std::cout << "Page " << (i + 1) << " skipped: time budget exceeded" << std::endl;
+      skipped.push_back(i);
     }
-
-    if (!ocr_doc->OcrImageToPage(image, &matrix, page, nullptr, nullptr))
-      throw PdfixException();
-    
-    page->Release();
+  }
+  if (cache) {
+    std::cout << "Pages recognized: " << cache->GetMisses() << ", reused: " << cache->GetHits()
+      << ", from disk: " << cache->GetDiskHits() << std::endl;
+    cache.reset();
   }
   
   if (!doc->Save(save_path.c_str(), kSaveFull))
@@ -103,4 +279,146 @@ void OcrWithTesseract(
 
   doc->Close();
   pdfix->Destroy();
-}
\ No newline at end of file
+  return skipped;
+}
+
+std::vector<int> OcrWithTesseractParallel(
+  const std::wstring& open_path,                  // source PDF document
+  const std::wstring& save_path,                  // searchable PDF document
+  const std::wstring& data_path,                  // path to OCR data
+  const std::wstring& language,                   // default OCR language
+  const double zoom,                              // page zoom level for rendering
+  const PdfRotate rotate,                         // page rotation
+  const ImageBufferFormat color_mode,             // color mode of the image passed to OCR
+  const size_t thread_count,                      // number of OCR workers
+  CancelToken* cancel,                            // cancel token of the whole job or nullptr
+  const int page_timeout                          // time budget per page in milliseconds, 0 for none
+) {
+  // initialize Pdfix
+  if (!Pdfix_init(Pdfix_MODULE_NAME))
+    throw std::runtime_error("Pdfix initialization fail");
+
+  Pdfix* pdfix = GetPdfix();
+  if (!pdfix)
+    throw std::runtime_error("GetPdfix fail");
+
+  auto ocr = InitializeOcr(pdfix, data_path, language);
+
+  PdfDoc* doc = pdfix->OpenDoc(open_path.c_str(), L"");
+  if (!doc)
+    throw PdfixException();
+
+  // each worker renders from its own copy of the document and recognizes into its own scratch
+  // document, the target document is not touched until all workers finished. GetOcrTesseract
+  // returns the single instance of the plugin, so the OCR documents holding the recognition state
+  // are opened here, one per worker, and the workers never call the shared instance.
+  size_t num_workers = std::max<size_t>(thread_count, 1);
+  auto doc_deleter = [](PdfDoc* doc) { doc->Close(); };
+  auto ocr_doc_deleter = [](TesseractDoc* ocr_doc) { ocr_doc->Close(); };
+  std::vector<std::unique_ptr<PdfDoc, decltype(doc_deleter)>> src_docs, ocr_pdfs;
+  std::vector<std::unique_ptr<TesseractDoc, decltype(ocr_doc_deleter)>> ocr_docs;
+  for (size_t i = 0; i < num_workers; i++) {
+    src_docs.emplace_back(pdfix->OpenDoc(open_path.c_str(), L""), doc_deleter);
+    ocr_pdfs.emplace_back(pdfix->CreateDoc(), doc_deleter);
+    if (!src_docs.back() || !ocr_pdfs.back())
+      throw PdfixException();
+    ocr_docs.emplace_back(ocr->OpenOcrDoc(ocr_pdfs.back().get()), ocr_doc_deleter);
+    if (!ocr_docs.back())
+      throw PdfixException();
+  }
+
+  int num_pages = doc->GetNumPages();
+  std::atomic<int> next_page(0);
+  std::vector<std::vector<int>> ocr_pages(num_workers);   // target page of each scratch page
+  std::vector<int> skipped;
+  std::exception_ptr error;
+  std::mutex mutex;                               // guards skipped and error
+
+  auto worker = [&](size_t index) {
+    try {
+      auto src_doc = src_docs[index].get();
+      auto ocr_pdf = ocr_pdfs[index].get();
+      auto& pages = ocr_pages[index];
+      auto page_deleter = [](PdfPage* page) { page->Release(); };
+      for (int i = next_page++; i < num_pages; i = next_page++) {
+        std::unique_ptr<PdfPage, decltype(page_deleter)> page(src_doc->AcquirePage(i),
+          page_deleter);
+        if (!page)
+          throw PdfixException();
+
+        PdfRect crop_box;
+        page->GetCropBox(&crop_box);
+        std::unique_ptr<PdfPage, decltype(page_deleter)> ocr_page(
+          ocr_pdf->CreatePage(-1, &crop_box), page_deleter);
+        if (!ocr_page)
+          throw PdfixException();
+
+        bool done = OcrPageWithBudget(ocr_docs[index].get(), nullptr, page.get(), ocr_page.get(),
+          zoom, rotate, color_mode, cancel, page_timeout, nullptr);
+        ocr_page.reset();
+        if (done) {
+          pages.push_back(i);
+          continue;
+        }
+        int last = (int)pages.size();
+        if (!ocr_pdf->DeletePages(last, last, nullptr, nullptr))
+          throw PdfixException();
+        std::lock_guard<std::mutex> lock(mutex);
+        skipped.push_back(i);
+      }
+    }
+    catch (...) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!error)
+        error = std::current_exception();
+      // stop the other workers
+      next_page = num_pages;
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < num_workers; i++)
+    workers.emplace_back(worker, i);
+  for (auto& w : workers)
+    w.join();
+  if (error)
+    std::rethrow_exception(error);
+
+  // add the text layers on this thread, the scratch pages have the crop box as media box, they
+  // map 1:1 to the page space
+  auto page_deleter = [](PdfPage* page) { page->Release(); };
+  for (size_t w = 0; w < num_workers; w++) {
+    for (size_t k = 0; k < ocr_pages[w].size(); k++) {
+      std::unique_ptr<PdfPage, decltype(page_deleter)> ocr_page(
+        ocr_pdfs[w]->AcquirePage((int)k), page_deleter);
+      std::unique_ptr<PdfPage, decltype(page_deleter)> page(
+        doc->AcquirePage(ocr_pages[w][k]), page_deleter);
+      if (!ocr_page || !page)
+        throw PdfixException();
+      auto xobject = doc->CreateXObjectFromPage(ocr_page.get());
+      if (!xobject)
+        throw PdfixException();
+      PdfMatrix matrix;
+      if (!page->GetContent()->AddNewForm(-1, xobject, &matrix))
+        throw PdfixException();
+      if (!page->SetContent())
+        throw PdfixException();
+    }
+  }
+  ocr_docs.clear();
+  ocr_pdfs.clear();
+  src_docs.clear();
+
+  std::sort(skipped.begin(), skipped.end());
+  for (auto i : skipped)
+    std::cout << "Page " << (i + 1) << " skipped: time budget exceeded" << std::endl;
+
+  if (!doc->Save(save_path.c_str(), kSaveFull))
+    throw PdfixException();
+
+  ocr->Destroy();
+
+  doc->Close();
+  pdfix->Destroy();
+  return skipped;
+}
@@ -0,0 +1,210 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// OutputSink.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/OutputSink.h"
+
+#include <string>
+#include <fstream>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include <filesystem>
+#ifdef PDFIX_SAMPLES_ZLIB
+#include <zlib.h>
+#endif
+#include "pdfixsdksamples/Utils.h"
+
+namespace fs = std::filesystem;
+
+OutputCompression GetOutputCompression(const std::wstring& path) {
+  auto pos = path.rfind(L".gz");
+  if (pos != std::wstring::npos && pos + 3 == path.size())
+    return kOutputGzip;
+  return kOutputPlain;
+}
+
+// Encoder compresses the data and writes them to the file, it runs on the sink thread
+class OutputSink::Encoder {
+public:
+  Encoder(const std::wstring& path, OutputCompression compression, int level)
+    : file_(fs::path(path), std::ios::binary | std::ios::trunc), compression_(compression) {
+    if (!file_)
+      throw std::runtime_error("Output file open fail");
+    if (compression_ != kOutputGzip)
+      return;
+#ifdef PDFIX_SAMPLES_ZLIB
+    // window bits over 15 make zlib write the gzip header and trailer
+    if (deflateInit2(&stream_, std::min(std::max(level, 1), 9), Z_DEFLATED, 15 + 16, 8,
+      Z_DEFAULT_STRATEGY) != Z_OK)
+      throw std::runtime_error("Output compression init fail");
+    stream_init_ = true;
+    out_.resize(1 << 16);
+#else
+    (void)level;
+    // gzip header: deflate, no flags, no time, unknown OS
+    const char header[] = { '\x1f', '\x8b', 8, 0, 0, 0, 0, 0, 0, '\xff' };
+    WriteFile(header, sizeof(header));
+#endif
+  }
+
+  ~Encoder() {
+#ifdef PDFIX_SAMPLES_ZLIB
+    if (stream_init_)
+      deflateEnd(&stream_);
+#endif
+  }
+
+  void Write(const char* data, size_t size) {
+    if (compression_ != kOutputGzip) {
+      WriteFile(data, size);
+      return;
+    }
+#ifdef PDFIX_SAMPLES_ZLIB
+    stream_.next_in = (Bytef*)data;
+    stream_.avail_in = (uInt)size;
+    Deflate(Z_NO_FLUSH);
+#else
+    // stored (uncompressed) deflate blocks
+    crc_ = Crc32(data, size, crc_);
+    length_ += (uint32_t)size;
+    for (size_t pos = 0; pos < size; ) {
+      size_t len = std::min<size_t>(size - pos, 0xffff);
+      const char block[] = { 0, (char)len, (char)(len >> 8), (char)~len, (char)(~len >> 8) };
+      WriteFile(block, sizeof(block));
+      WriteFile(data + pos, len);
+      pos += len;
+    }
+#endif
+  }
+
+  void Finish() {
+    if (compression_ == kOutputGzip) {
+#ifdef PDFIX_SAMPLES_ZLIB
+      stream_.next_in = nullptr;
+      stream_.avail_in = 0;
+      Deflate(Z_FINISH);
+#else
+      // empty final block and the trailer with CRC-32 and length, little endian
+      const char last[] = { 1, 0, 0, '\xff', '\xff' };
+      WriteFile(last, sizeof(last));
+      char trailer[8];
+      for (int i = 0; i < 4; i++) {
+        trailer[i] = (char)(crc_ >> (8 * i));
+        trailer[4 + i] = (char)(length_ >> (8 * i));
+      }
+      WriteFile(trailer, sizeof(trailer));
+#endif
+    }
+    file_.close();
+    if (!file_)
+      throw std::runtime_error("Output file write fail");
+  }
+
+private:
+  void WriteFile(const char* data, size_t size) {
+    if (!file_.write(data, size))
+      throw std::runtime_error("Output file write fail");
+  }
+
+#ifdef PDFIX_SAMPLES_ZLIB
+  void Deflate(int flush) {
+    int ret = Z_OK;
+    do {
+      stream_.next_out = (Bytef*)out_.data();
+      stream_.avail_out = (uInt)out_.size();
+      ret = deflate(&stream_, flush);
+      if (ret == Z_STREAM_ERROR)
+        throw std::runtime_error("Output compression fail");
+      WriteFile(out_.data(), out_.size() - stream_.avail_out);
+    } while (stream_.avail_out == 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+  }
+
+  z_stream stream_ = {};
+  bool stream_init_ = false;
+  std::vector<char> out_;
+#else
+  uint32_t crc_ = 0;
+  uint32_t length_ = 0;               // uncompressed size modulo 2^32
+#endif
+  std::ofstream file_;
+  OutputCompression compression_;
+};
+
+OutputSink::Buffer::Buffer(OutputSink& sink, size_t chunk_size)
+  : sink_(sink), chunk_(std::max<size_t>(chunk_size, 1)) {
+  setp(chunk_.data(), chunk_.data() + chunk_.size());
+}
+
+// hands the buffered data to the sink thread, false if the thread has failed
+bool OutputSink::Buffer::Flush() {
+  size_t size = pptr() - pbase();
+  if (size == 0)
+    return true;
+  size_t capacity = chunk_.size();
+  chunk_.resize(size);
+  bool pushed = sink_.queue_.Push(std::move(chunk_));
+  chunk_ = std::vector<char>(capacity);
+  setp(chunk_.data(), chunk_.data() + chunk_.size());
+  return pushed;
+}
+
+OutputSink::Buffer::int_type OutputSink::Buffer::overflow(int_type ch) {
+  if (!Flush())
+    return traits_type::eof();
+  if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(ch);
+    pbump(1);
+  }
+  return traits_type::not_eof(ch);
+}
+
+// std::endl flushes the stream, the data are handed over only in full chunks and on Close
+int OutputSink::Buffer::sync() {
+  return 0;
+}
+
+OutputSink::OutputSink(
+  const std::wstring& path,         // output file
+  OutputCompression compression,    // output file compression
+  int level,                        // compression level 1 to 9
+  size_t chunk_size                 // size of the data handed to the compression thread
+) : std::ostream(nullptr), encoder_(new Encoder(path, compression, level)), queue_(4),
+  buffer_(*this, chunk_size) {
+  rdbuf(&buffer_);
+  thread_ = std::thread(&OutputSink::Compress, this);
+}
+
+OutputSink::~OutputSink() {
+  try {
+    Close();
+  }
+  catch (...) {
+  }
+}
+
+void OutputSink::Close() {
+  if (closed_)
+    return;
+  closed_ = true;
+  buffer_.Flush();
+  queue_.Close();
+  thread_.join();
+  if (error_)
+    std::rethrow_exception(error_);
+}
+
+void OutputSink::Compress() {
+  try {
+    std::vector<char> chunk;
+    while (queue_.Pop(chunk))
+      encoder_->Write(chunk.data(), chunk.size());
+    encoder_->Finish();
+  }
+  catch (...) {
+    error_ = std::current_exception();
+    // the writer stops at the next full chunk
+    queue_.Close();
+  }
+}
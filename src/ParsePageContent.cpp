@@ -8,6 +8,8 @@
 // system
 #include <string>
 #include <iostream>
+#include <memory>
+#include <unordered_set>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 // project
@@ -20,7 +22,8 @@ using namespace boost::property_tree;
 namespace ParsePageContent {
 
   // ProcessObject gets the value of the object.
-  void ProcessPageObject(PdsPageObject* obj, std::ostream& ss, std::string indent) {
+  void ProcessPageObject(PdsPageObject* obj, std::ostream& ss, std::string indent,
+    std::unordered_set<int>& forms) {
     
     if (!obj) throw PdfixException();
     indent += "  ";
@@ -67,7 +70,25 @@ namespace ParsePageContent {
       case kPdsPageForm: {
         ss << "form" << std::endl;
         auto form = (PdsForm*)obj;
-        auto content = form->AcquireContent();
+        PdfMatrix m;
+        if (form->GetMatrix(&m))
+          ss << indent << "matrix: " << (float)m.a << " " << (float)m.b << " " << (float)m.c
+            << " " << (float)m.d << " " << (float)m.e << " " << (float)m.f << std::endl;
+        auto xobject = form->GetObject();
+        int id = xobject ? xobject->GetId() : 0;
+        if (id > 0) {
+          ss << indent << "xobject: " << id << std::endl;
+          // the kids of a repeated Form XObject were listed at its first use
+          if (!forms.insert(id).second) {
+            ss << indent << "ref: true" << std::endl;
+            break;
+          }
+        }
+        auto content_deleter = [](PdsContent* content) { content->Release(); };
+        std::unique_ptr<PdsContent, decltype(content_deleter)> content(form->AcquireContent(),
+          content_deleter);
+        if (!content)
+          throw PdfixException();
         auto objects_num = content->GetNumObjects();
         if (objects_num > 0) {
           ss << indent << "/kids" << std::endl;
@@ -75,7 +96,7 @@ namespace ParsePageContent {
           for (int i = 0; i < content->GetNumObjects(); i++) {
             ss << indent << "/" << i << std::endl;
             auto kid = content->GetObject(i);
-            ProcessPageObject(kid, ss, indent );
+            ProcessPageObject(kid, ss, indent, forms);
           }
           indent = indent.substr(0, indent.length() - 2);
         }
@@ -144,9 +165,10 @@ namespace ParsePageContent {
     indent += "  ";
     auto content = page->GetContent();
     auto count = content->GetNumObjects();
+    std::unordered_set<int> forms;
     for (int i = 0; i < count; i++) {
       output << indent << "/" << i << std::endl;
-      ProcessPageObject(content->GetObject(i), output, indent);
+      ProcessPageObject(content->GetObject(i), output, indent, forms);
     }
 
     page->Release();
@@ -13,7 +13,8 @@ using namespace PDFixSDK;
 
 void RemoveTags(
   const std::wstring& open_path,        // source PDF document
-  const std::wstring& save_path        // output PDF document
+  const std::wstring& save_path,       // output PDF document
+  CancelToken* cancel                   // cancel token or nullptr
 ) {
   // initialize Pdfix
   if (!Pdfix_init(Pdfix_MODULE_NAME))
@@ -27,8 +28,10 @@ void RemoveTags(
   if (!doc)
     throw PdfixException();
   
-  if (!doc->RemoveTags(nullptr, nullptr))
+  if (!doc->RemoveTags(&CancelToken::CancelProc, cancel)) {
+    CancelToken::ThrowIfStopped(cancel);
     throw PdfixException();
+  }
 
   if (!doc->Save(save_path.c_str(), kSaveFull))
     throw PdfixException();
@@ -7,10 +7,199 @@
 
 #include <string>
 #include <iostream>
+#include <memory>
+#include <algorithm>
+#include "pdfixsdksamples/Utils.h"
 #include "Pdfix.h"
 
 using namespace PDFixSDK;
 
+PsImage* RenderPageImage(
+  PdfPage* page,                              // page to render
+  double zoom,                                // page zoom
+  PdfRotate rotate,                           // page rotation
+  PdfDevRect clip_rect,                       // clip region, empty for the whole page
+  int render_flags,                           // PdfRenderFlags, e.g. kRenderGrayscale
+  int& width,                                 // rendered image width
+  int& height,                                // rendered image height
+  CancelToken* cancel                         // cancel token or nullptr
+) {
+  auto page_view_deleter = [](PdfPageView* page_view) { page_view->Release(); };
+  std::unique_ptr<PdfPageView, decltype(page_view_deleter)> page_view(
+    page->AcquirePageView(zoom, rotate), page_view_deleter);
+  if (!page_view)
+    throw PdfixException();
+
+  width = page_view->GetDeviceWidth();
+  height = page_view->GetDeviceHeight();
+
+  PdfRect clip_box;
+  if (!(clip_rect.left == 0 && clip_rect.right == 0 &&
+      clip_rect.top == 0 && clip_rect.bottom == 0)) {
+    width = clip_rect.right - clip_rect.left;
+    height = clip_rect.bottom - clip_rect.top;
+    page_view->RectToPage(&clip_rect, &clip_box);
+  }
+
+  PsImage* image = GetPdfix()->CreateImage(width, height, kImageDIBFormatArgb);
+  if (!image)
+    throw PdfixException();
+
+  PdfPageRenderParams params;
+  params.image = image;
+  params.clip_box = clip_box;
+  page_view->GetDeviceMatrix(&params.matrix);
+  // the clip region starts at the image origin
+  PdfMatrixTranslate(params.matrix, -clip_rect.left, -clip_rect.top, false);
+  params.render_flags = render_flags;
+  if (!page->DrawContent(&params, &CancelToken::CancelProc, cancel)) {
+    image->Destroy();
+    CancelToken::ThrowIfStopped(cancel);
+    throw PdfixException();
+  }
+  return image;
+}
+
+void RenderPageToStream(
+  PdfPage* page,                              // page to render
+  PsStream* stream,                           // output stream
+  PdfImageParams img_params,                  // output image params
+  double zoom,                                // page zoom
+  PdfRotate rotate,                           // page rotation
+  PdfDevRect clip_rect,                       // clip region, empty for the whole page
+  CancelToken* cancel                         // cancel token or nullptr
+) {
+  int width = 0, height = 0;
+  auto image_deleter = [](PsImage* image) { image->Destroy(); };
+  std::unique_ptr<PsImage, decltype(image_deleter)> image(
+    RenderPageImage(page, zoom, rotate, clip_rect, kRenderAnnot, width, height, cancel),
+    image_deleter);
+  if (!image->SaveToStream(stream, &img_params))
+    throw PdfixException();
+}
+
+// render into a memory stream and let the caller read it with read_proc
+template <typename ReadProc>
+static auto RenderPageToMemStream(PdfPage* page, PdfImageParams img_params, double zoom,
+  PdfRotate rotate, PdfDevRect clip_rect, CancelToken* cancel, ReadProc read_proc) {
+  auto stm_deleter = [](PsStream* stm) { stm->Destroy(); };
+  std::unique_ptr<PsStream, decltype(stm_deleter)> stm(GetPdfix()->CreateMemStream(), stm_deleter);
+  if (!stm)
+    throw PdfixException();
+  RenderPageToStream(page, stm.get(), img_params, zoom, rotate, clip_rect, cancel);
+  return read_proc(stm.get());
+}
+
+std::vector<uint8_t> RenderPageToMemory(
+  PdfPage* page,                              // page to render
+  PdfImageParams img_params,                  // output image params
+  double zoom,                                // page zoom
+  PdfRotate rotate,                           // page rotation
+  PdfDevRect clip_rect,                       // clip region, empty for the whole page
+  CancelToken* cancel                         // cancel token or nullptr
+) {
+  auto read_proc = [](PsStream* stm) {
+    std::vector<uint8_t> data(stm->GetSize());
+    if (!data.empty() && !stm->Read(0, data.data(), (int)data.size()))
+      throw PdfixException();
+    return data;
+  };
+  return RenderPageToMemStream(page, img_params, zoom, rotate, clip_rect, cancel, read_proc);
+}
+
+size_t RenderPageToBuffer(
+  PdfPage* page,                              // page to render
+  PdfImageParams img_params,                  // output image params
+  double zoom,                                // page zoom
+  PdfRotate rotate,                           // page rotation
+  PdfDevRect clip_rect,                       // clip region, empty for the whole page
+  uint8_t* buffer,                            // output buffer
+  size_t buffer_size,                         // output buffer size
+  CancelToken* cancel                         // cancel token or nullptr
+) {
+  auto read_proc = [&](PsStream* stm) {
+    size_t size = stm->GetSize();
+    if (size && size <= buffer_size && !stm->Read(0, buffer, (int)size))
+      throw PdfixException();
+    return size;
+  };
+  return RenderPageToMemStream(page, img_params, zoom, rotate, clip_rect, cancel, read_proc);
+}
+
+void RenderPagePixels(
+  PdfPage* page,                              // page to render
+  double zoom,                                // page zoom
+  PdfRotate rotate,                           // page rotation
+  PdfDevRect clip_rect,                       // clip region, empty for the whole page
+  ImageBufferFormat format,                   // output pixel format
+  ImageBuffer& pixels,                        // output pixels
+  CancelToken* cancel                         // cancel token or nullptr
+) {
+  int render_flags = kRenderAnnot;
+  if (format != kImageBufferBgra)
+    render_flags |= kRenderGrayscale;
+
+  int width = 0, height = 0;
+  auto image_deleter = [](PsImage* image) { image->Destroy(); };
+  std::unique_ptr<PsImage, decltype(image_deleter)> image(
+    RenderPageImage(page, zoom, rotate, clip_rect, render_flags, width, height, cancel),
+    image_deleter);
+  if (format == kImageBufferBgra) {
+    ReadImagePixels(image.get(), width, height, pixels);
+    return;
+  }
+
+  ImageBuffer bgra;
+  ReadImagePixels(image.get(), width, height, bgra);
+  image.reset();
+  if (format == kImageBufferGray) {
+    ConvertToGray(bgra, pixels);
+    return;
+  }
+  ImageBuffer gray;
+  ConvertToGray(bgra, gray);
+  bgra.data.clear();
+  ThresholdAdaptive(gray, pixels, std::max(15, width / 8), 15);
+}
+
+void RenderPageGray(
+  const std::wstring& open_path,              // source PDF document
+  const std::wstring& img_path,               // output PNG image
+  int page_num,                               // page number
+  double zoom,                                // page zoom
+  PdfRotate rotate,                           // page rotation
+  PdfDevRect clip_rect,                       // clip region
+  ImageBufferFormat format                    // kImageBufferGray or kImageBufferBitonal
+) {
+  // initialize Pdfix
+  if (!Pdfix_init(Pdfix_MODULE_NAME))
+    throw std::runtime_error("Pdfix initialization fail");
+
+  Pdfix* pdfix = GetPdfix();
+  if (!pdfix)
+    throw std::runtime_error("GetPdfix fail");
+
+  if (format == kImageBufferBgra)
+    throw std::runtime_error("Unsupported image buffer format");
+
+  PdfDoc* doc = pdfix->OpenDoc(open_path.c_str(), L"");
+  if (!doc)
+    throw PdfixException();
+
+  PdfPage* page = doc->AcquirePage(page_num);
+  if (!page)
+    throw PdfixException();
+
+  ImageBuffer pixels;
+  RenderPagePixels(page, zoom, rotate, clip_rect, format, pixels, nullptr);
+  SaveImageBuffer(pixels, img_path);
+
+  page->Release();
+  doc->Close();
+
+  pdfix->Destroy();
+}
+
 void RenderPage(
   const std::wstring& open_path,              // source PDF document
   const std::wstring& img_path,               // output image
@@ -36,42 +225,15 @@ void RenderPage(
   PdfPage* page = doc->AcquirePage(page_num);
   if (!page)
     throw PdfixException();
-  PdfPageView* page_view = page->AcquirePageView(zoom, rotate);
-  if (!page_view)
-    throw PdfixException();
-
-  int width = page_view->GetDeviceWidth();
-  int height = page_view->GetDeviceHeight();
-  
-  PdfRect clip_box;
-  if (!(clip_rect.left == 0 && clip_rect.right == 0 &&
-      clip_rect.top == 0 && clip_rect.bottom == 0)) {
-    width = clip_rect.right - clip_rect.left;
-    height = clip_rect.bottom - clip_rect.top;
-    page_view->RectToPage(&clip_rect, &clip_box);
-  }
-  
-  PsImage* image = pdfix->CreateImage(width, height, kImageDIBFormatArgb);
-  if (!image)
-    throw PdfixException();
-
-  PdfPageRenderParams params;
-  params.image = image;
-  params.clip_box = clip_box;
-  page_view->GetDeviceMatrix(&params.matrix);
-  params.render_flags = kRenderAnnot; // | kRenderGrayscale;
-  if (!page->DrawContent(&params, nullptr, nullptr))
-    throw PdfixException();
 
   auto stream = pdfix->CreateFileStream(img_path.c_str(), kPsTruncate);
   if (!stream)
     throw PdfixException();
-  if (!image->SaveToStream(stream, &img_params))
-    throw PdfixException();
+  RenderPageToStream(page, stream, img_params, zoom, rotate, clip_rect, nullptr);
   stream->Destroy();
 
   page->Release();
   doc->Close();
 
   pdfix->Destroy();
-}
\ No newline at end of file
+}
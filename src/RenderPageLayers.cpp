@@ -0,0 +1,169 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// RenderPageLayers.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/RenderPageLayers.h"
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include "pdfixsdksamples/ReadOCGLayers.h"
+#include "pdfixsdksamples/RenderPage.h"
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+namespace RenderPageLayers {
+
+  // OCG ids of the optional content marks of the object, one entry per OC tag
+  static void GetOptionalContent(PdsPageObject* object, std::vector<std::vector<int>>& groups) {
+    auto content_mark = object->GetContentMark();
+    if (!content_mark)
+      return;
+    for (auto i = 0; i < content_mark->GetNumTags(); i++) {
+      if (content_mark->GetTagName(i) != L"OC")
+        continue;
+      auto oc = content_mark->GetTagObject(i);
+      if (!oc)
+        continue;
+
+      // NOTE: OCMD is handled with the default AnyOn policy, visibility expressions are ignored
+      std::vector<int> ocg_ids;
+      if (oc->GetText(L"Type") == L"OCMD") {
+        auto ocg_dict = oc->GetDictionary(L"OCGs");
+        if (ocg_dict)
+          ocg_ids.push_back(ocg_dict->GetId());
+        auto ocg_arr = oc->GetArray(L"OCGs");
+        if (ocg_arr) {
+          for (auto j = 0; j < ocg_arr->GetNumObjects(); j++) {
+            auto ocg = ocg_arr->GetDictionary(j);
+            if (ocg)
+              ocg_ids.push_back(ocg->GetId());
+          }
+        }
+      }
+      else {
+        ocg_ids.push_back(oc->GetId());
+      }
+      if (!ocg_ids.empty())
+        groups.push_back(ocg_ids);
+    }
+  }
+
+  PageLayerMask::PageLayerMask(PdfPage* page) {
+    auto content = page->GetContent();
+    if (!content)
+      throw PdfixException();
+    std::vector<size_t> no_groups;
+    for (int i = 0; i < content->GetNumObjects(); i++)
+      AddObject(content->GetObject(i), no_groups);
+  }
+
+  void PageLayerMask::AddObject(PdsPageObject* object, const std::vector<size_t>& parent_groups) {
+    if (!object)
+      return;
+    Item item;
+    item.object = object;
+    item.type = object->GetObjectType();
+    item.groups = parent_groups;
+    item.rendered = true;
+
+    std::vector<std::vector<int>> groups;
+    GetOptionalContent(object, groups);
+    for (auto& group : groups) {
+      item.groups.push_back(groups_.size());
+      groups_.push_back(group);
+    }
+
+    // objects nested in a form inherit the optional content of the form
+    std::vector<size_t> child_groups = item.groups;
+    items_.push_back(item);
+    if (item.type == kPdsPageForm) {
+      PdsForm* form = (PdsForm*)object;
+      auto content_deleter = [](PdsContent* content) { content->Release(); };
+      form_contents_.emplace_back(form->AcquireContent(), content_deleter);
+      auto content = form_contents_.back().get();
+      if (!content)
+        throw PdfixException();
+      for (int i = 0; i < content->GetNumObjects(); i++)
+        AddObject(content->GetObject(i), child_groups);
+    }
+  }
+
+  void PageLayerMask::Apply(const LayerSelection& selection) {
+    // evaluate each OC mark once
+    std::vector<char> group_visible(groups_.size());
+    for (size_t i = 0; i < groups_.size(); i++) {
+      group_visible[i] = std::any_of(groups_[i].begin(), groups_[i].end(),
+        [&](int id) { return selection.hidden_layers.count(id) == 0; });
+    }
+
+    for (auto& item : items_) {
+      // forms stay rendered unless hidden by their own layer, their children are set one by one
+      bool render = item.type == kPdsPageForm || selection.hidden_types.count(item.type) == 0;
+      for (auto group : item.groups)
+        render = render && group_visible[group];
+      if (!applied_ || render != item.rendered) {
+        item.object->SetRender(render);
+        item.rendered = render;
+      }
+    }
+    applied_ = true;
+  }
+
+  void Run(
+    const std::wstring& open_path,              // source PDF document
+    const std::wstring& img_path,               // output image path prefix
+    int page_num,                               // page number
+    const std::vector<double>& zooms,           // page zooms
+    PdfRotate rotate                            // page rotation
+  ) {
+    // initialize Pdfix
+    if (!Pdfix_init(Pdfix_MODULE_NAME))
+      throw std::runtime_error("Pdfix initialization fail");
+
+    Pdfix* pdfix = GetPdfix();
+    if (!pdfix)
+      throw std::runtime_error("GetPdfix fail");
+
+    PdfDoc* doc = pdfix->OpenDoc(open_path.c_str(), L"");
+    if (!doc)
+      throw PdfixException();
+
+    PdfPage* page = doc->AcquirePage(page_num);
+    if (!page)
+      throw PdfixException();
+
+    auto layers = ReadOCGLayers::ReadLayerNames(doc->GetRootObject());
+    PageLayerMask mask(page);
+
+    PdfImageParams img_params;
+    img_params.format = kImageFormatPng;
+    for (auto& layer : layers) {
+      // show only the current layer
+      LayerSelection selection;
+      for (auto& other : layers) {
+        if (other.second != layer.second)
+          selection.hidden_layers.insert(other.second);
+      }
+      mask.Apply(selection);
+
+      for (size_t i = 0; i < zooms.size(); i++) {
+        std::wstringstream ss;
+        ss << img_path << L"layer" << layer.second << L"_" << i << L".png";
+        auto stream = pdfix->CreateFileStream(ss.str().c_str(), kPsTruncate);
+        if (!stream)
+          throw PdfixException();
+        RenderPageToStream(page, stream, img_params, zooms[i], rotate, PdfDevRect(), nullptr);
+        stream->Destroy();
+      }
+    }
+
+    page->Release();
+    doc->Close();
+
+    pdfix->Destroy();
+  }
+}
@@ -0,0 +1,183 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// RenderPageTiles.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/RenderPageTiles.h"
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <memory>
+#include <algorithm>
+#include <filesystem>
+#include "pdfixsdksamples/Utils.h"
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+namespace RenderPageTiles {
+
+  // render one tile of the page view, the device matrix is shifted to the tile origin
+  void RenderTile(
+    PdfPage* page,                              // page to render
+    PdfPageView* page_view,                     // page view defining zoom and rotation
+    int col,                                    // tile column
+    int row,                                    // tile row
+    int tile_size,                              // tile width and height in pixels
+    ImageBuffer& tile,                          // output tile pixels
+    CancelToken* cancel                         // cancel token or nullptr
+  ) {
+    PdfDevRect dev_rect;
+    dev_rect.left = col * tile_size;
+    dev_rect.top = row * tile_size;
+    dev_rect.right = std::min(dev_rect.left + tile_size, page_view->GetDeviceWidth());
+    dev_rect.bottom = std::min(dev_rect.top + tile_size, page_view->GetDeviceHeight());
+    int width = dev_rect.right - dev_rect.left;
+    int height = dev_rect.bottom - dev_rect.top;
+    if (width <= 0 || height <= 0)
+      throw std::runtime_error("Tile out of page");
+
+    auto image_deleter = [](PsImage* image) { image->Destroy(); };
+    std::unique_ptr<PsImage, decltype(image_deleter)> image(
+      GetPdfix()->CreateImage(width, height, kImageDIBFormatArgb), image_deleter);
+    if (!image)
+      throw PdfixException();
+
+    PdfPageRenderParams params;
+    params.image = image.get();
+    page_view->RectToPage(&dev_rect, &params.clip_box);
+    page_view->GetDeviceMatrix(&params.matrix);
+    PdfMatrixTranslate(params.matrix, -dev_rect.left, -dev_rect.top, false);
+    params.render_flags = kRenderAnnot;
+    if (!page->DrawContent(&params, &CancelToken::CancelProc, cancel)) {
+      CancelToken::ThrowIfStopped(cancel);
+      throw PdfixException();
+    }
+
+    ReadImagePixels(image.get(), width, height, tile);
+  }
+
+  // DeepZoom pyramid writer, level max_level is the rendered resolution, level 0 is 1x1 pixel
+  struct TilePyramid {
+    PdfPage* page;
+    PdfPageView* page_view;
+    int tile_size;
+    int width;
+    int height;
+    int max_level;
+    std::wstring tiles_dir;
+    CancelToken* cancel;
+
+    int LevelWidth(int level) const {
+      int scale = max_level - level;
+      return (int)(((long long)width + (1ll << scale) - 1) >> scale);
+    }
+    int LevelHeight(int level) const {
+      int scale = max_level - level;
+      return (int)(((long long)height + (1ll << scale) - 1) >> scale);
+    }
+    int NumCols(int level) const { return (LevelWidth(level) + tile_size - 1) / tile_size; }
+    int NumRows(int level) const { return (LevelHeight(level) + tile_size - 1) / tile_size; }
+
+    // build the tile from its four children of the next level and save it
+    void BuildTile(int level, int col, int row, ImageBuffer& tile) {
+      if (level == max_level) {
+        RenderTile(page, page_view, col, row, tile_size, tile, cancel);
+      }
+      else {
+        int child_level = level + 1;
+        int left = 2 * col * tile_size;
+        int top = 2 * row * tile_size;
+        ImageBuffer children;
+        children.Create(std::min(2 * tile_size, LevelWidth(child_level) - left),
+          std::min(2 * tile_size, LevelHeight(child_level) - top), kImageBufferBgra);
+
+        ImageBuffer child;
+        for (int r = 2 * row; r < std::min(2 * row + 2, NumRows(child_level)); r++) {
+          for (int c = 2 * col; c < std::min(2 * col + 2, NumCols(child_level)); c++) {
+            BuildTile(child_level, c, r, child);
+            BlitImageBuffer(child, children, (c - 2 * col) * tile_size, (r - 2 * row) * tile_size);
+          }
+        }
+        DownscaleHalf(children, tile);
+      }
+
+      std::wstringstream ss;
+      ss << tiles_dir << L"/" << level << L"/" << col << L"_" << row << L".png";
+      SaveImageBuffer(tile, ss.str());
+    }
+  };
+
+  void Run(
+    const std::wstring& open_path,              // source PDF document
+    const std::wstring& save_path,              // output .dzi file, tiles go to <name>_files
+    int page_num,                               // page number
+    double zoom,                                // page zoom of the deepest level
+    PdfRotate rotate,                           // page rotation
+    int tile_size,                              // tile width and height in pixels
+    CancelToken* cancel                         // cancel token or nullptr
+  ) {
+    // initialize Pdfix
+    if (!Pdfix_init(Pdfix_MODULE_NAME))
+      throw std::runtime_error("Pdfix initialization fail");
+
+    Pdfix* pdfix = GetPdfix();
+    if (!pdfix)
+      throw std::runtime_error("GetPdfix fail");
+
+    if (tile_size <= 0)
+      throw std::runtime_error("Invalid tile size");
+
+    PdfDoc* doc = pdfix->OpenDoc(open_path.c_str(), L"");
+    if (!doc)
+      throw PdfixException();
+
+    PdfPage* page = doc->AcquirePage(page_num);
+    if (!page)
+      throw PdfixException();
+    PdfPageView* page_view = page->AcquirePageView(zoom, rotate);
+    if (!page_view)
+      throw PdfixException();
+
+    TilePyramid pyramid;
+    pyramid.page = page;
+    pyramid.page_view = page_view;
+    pyramid.cancel = cancel;
+    pyramid.tile_size = tile_size;
+    pyramid.width = page_view->GetDeviceWidth();
+    pyramid.height = page_view->GetDeviceHeight();
+    pyramid.max_level = 0;
+    while ((1ll << pyramid.max_level) < std::max(pyramid.width, pyramid.height))
+      pyramid.max_level++;
+
+    std::wstring base_path = save_path;
+    auto ext_pos = base_path.rfind(L".dzi");
+    if (ext_pos != std::wstring::npos && ext_pos + 4 == base_path.size())
+      base_path.erase(ext_pos);
+    pyramid.tiles_dir = base_path + L"_files";
+    for (int level = 0; level <= pyramid.max_level; level++)
+      std::filesystem::create_directories(std::filesystem::path(pyramid.tiles_dir) /
+        std::to_wstring(level));
+
+    ImageBuffer root;
+    pyramid.BuildTile(0, 0, 0, root);
+
+    // DeepZoom descriptor
+    std::stringstream dzi;
+    dzi << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>" << std::endl;
+    dzi << "<Image xmlns=\"http://schemas.microsoft.com/deepzoom/2008\" TileSize=\"" << tile_size
+      << "\" Overlap=\"0\" Format=\"png\">" << std::endl;
+    dzi << "  <Size Width=\"" << pyramid.width << "\" Height=\"" << pyramid.height << "\"/>"
+      << std::endl;
+    dzi << "</Image>" << std::endl;
+    auto str = dzi.str();
+    SaveBytes(std::vector<uint8_t>(str.begin(), str.end()), base_path + L".dzi");
+
+    page_view->Release();
+    page->Release();
+    doc->Close();
+
+    pdfix->Destroy();
+  }
+}
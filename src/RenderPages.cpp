@@ -9,11 +9,41 @@
 #include <iostream>
 #include <thread>
 #include <sstream>
+#include <atomic>
+#include <memory>
+#include <exception>
+#include <mutex>
+#include <algorithm>
+#include <cmath>
+#include "pdfixsdksamples/ImagePipeline.h"
+#include "pdfixsdksamples/RenderPage.h"
 #include "Pdfix.h"
 
 using namespace PDFixSDK;
 
-void RenderPages(
+// render the page with its own time budget, returns nullptr when the budget was exceeded
+static PsImage* RenderPageWithBudget(PdfPage* page, double zoom, PdfRotate rotate,
+  PdfDevRect clip_rect, CancelToken* cancel, int page_timeout, int& width, int& height) {
+  CancelToken page_cancel(cancel, page_timeout);
+  try {
+    return RenderPageImage(page, zoom, rotate, clip_rect, kRenderAnnot, width, height,
+      &page_cancel);
+  }
+  catch (CancelException& e) {
+    // the whole job stops when the parent token stopped, only the page is skipped otherwise
+    if (!e.IsExpired() || (cancel && cancel->IsStopped()))
+      throw;
+    return nullptr;
+  }
+}
+
+static void ReportSkippedPages(std::vector<int>& skipped) {
+  std::sort(skipped.begin(), skipped.end());
+  for (auto i : skipped)
+    std::cout << "Page " << (i + 1) << " skipped: time budget exceeded" << std::endl;
+}
+
+std::vector<int> RenderPages(
   const std::wstring& open_path,              // source PDF document
   const std::wstring& img_path,               // output image
   PdfImageParams img_params,                  // output image params
@@ -22,7 +52,9 @@ void RenderPages(
   double zoom,                                // page zoom
   PdfRotate rotate,                           // page rotation
   PdfDevRect clip_rect,                       // clip region
-  size_t thread_count                         // max number of threads
+  size_t thread_count,                        // max number of threads
+  CancelToken* cancel,                        // cancel token of the whole job or nullptr
+  int page_timeout                            // time budget per page in milliseconds, 0 for none
 ) {
   // initialize Pdfix
   if (!Pdfix_init(Pdfix_MODULE_NAME))
@@ -40,49 +72,42 @@ void RenderPages(
   if (page_from > page_count || page_to > page_count)
     throw std::runtime_error("Page number out of range");
 
+  std::vector<int> skipped;
+  std::exception_ptr render_error;
+  std::mutex mutex;
+
   auto render_page = [&](auto from, auto to) {
-    for (size_t i = from; i <= to; i++) {
-      // render first page to jpg image
-      PdfPage* page = doc->AcquirePage(i);
-      if (!page)
-        throw PdfixException();
-      PdfPageView* page_view = page->AcquirePageView(zoom, rotate);
-      if (!page_view)
-        throw PdfixException();
-
-      int width = page_view->GetDeviceWidth();
-      int height = page_view->GetDeviceHeight();
-
-      PdfRect clip_box;
-      if (!(clip_rect.left == 0 && clip_rect.right == 0 &&
-        clip_rect.top == 0 && clip_rect.bottom == 0)) {
-        width = clip_rect.right - clip_rect.left;
-        height = clip_rect.bottom - clip_rect.top;
-        page_view->RectToPage(&clip_rect, &clip_box);
-      }
+    try {
+      for (size_t i = from; i <= to; i++) {
+        auto page_deleter = [](PdfPage* page) { page->Release(); };
+        std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(i), page_deleter);
+        if (!page)
+          throw PdfixException();
 
-      PsImage* image = pdfix->CreateImage(width, height, kImageDIBFormatArgb);
-      if (!image)
-        throw PdfixException();
-
-      PdfPageRenderParams params;
-      params.image = image;
-      params.clip_box = clip_box;
-      page_view->GetDeviceMatrix(&params.matrix);
-      params.render_flags = kRenderAnnot; // | kRenderGrayscale;
-      if (!page->DrawContent(&params, nullptr, nullptr))
-        throw PdfixException();
-
-      std::wstringstream ss;
-      ss << img_path << L"page" << (i + 1) << L".png";
-      auto stream = pdfix->CreateFileStream(ss.str().c_str(), kPsTruncate);
-      if (!stream)
-        throw PdfixException();
-      if (!image->SaveToStream(stream, &img_params))
-        throw PdfixException();
-      stream->Destroy();
-
-      page->Release();
+        int width = 0, height = 0;
+        auto image_deleter = [](PsImage* image) { image->Destroy(); };
+        std::unique_ptr<PsImage, decltype(image_deleter)> image(RenderPageWithBudget(page.get(),
+          zoom, rotate, clip_rect, cancel, page_timeout, width, height), image_deleter);
+        if (!image) {
+          std::lock_guard<std::mutex> lock(mutex);
+          skipped.push_back((int)i);
+          continue;
+        }
+
+        std::wstringstream ss;
+        ss << img_path << L"page" << (i + 1) << L".png";
+        auto stream = pdfix->CreateFileStream(ss.str().c_str(), kPsTruncate);
+        if (!stream)
+          throw PdfixException();
+        if (!image->SaveToStream(stream, &img_params))
+          throw PdfixException();
+        stream->Destroy();
+      }
+    }
+    catch (...) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!render_error)
+        render_error = std::current_exception();
     }
   };
 
@@ -107,8 +132,211 @@ void RenderPages(
   for (auto& w : workers) {
     w.join();
   }
+  if (render_error)
+    std::rethrow_exception(render_error);
 
   doc->Close();
 
   pdfix->Destroy();
-}
\ No newline at end of file
+
+  ReportSkippedPages(skipped);
+  return skipped;
+}
+
+std::vector<int> RenderPagesPipelined(
+  const std::wstring& open_path,              // source PDF document
+  const std::wstring& img_path,               // output image
+  PdfImageParams img_params,                  // output image params
+  int page_from,                              // page from
+  int page_to,                                // page to
+  double zoom,                                // page zoom
+  PdfRotate rotate,                           // page rotation
+  PdfDevRect clip_rect,                       // clip region
+  size_t render_threads,                      // number of render threads
+  size_t encode_threads,                      // number of encoder threads
+  size_t queue_size,                          // max number of rendered pages waiting for encoder
+  CancelToken* cancel,                        // cancel token of the whole job or nullptr
+  int page_timeout                            // time budget per page in milliseconds, 0 for none
+) {
+  // initialize Pdfix
+  if (!Pdfix_init(Pdfix_MODULE_NAME))
+    throw PdfixException();
+
+  Pdfix* pdfix = GetPdfix();
+  if (!pdfix)
+    throw std::runtime_error("GetPdfix fail");
+
+  PdfDoc* doc = pdfix->OpenDoc(open_path.c_str(), L"");
+  if (!doc)
+    throw PdfixException();
+
+  auto page_count = doc->GetNumPages();
+  if (page_from > page_count || page_to > page_count)
+    throw std::runtime_error("Page number out of range");
+
+  ImagePipeline pipeline(img_params, encode_threads, queue_size);
+
+  // render workers pick the next page, the pipeline blocks them when encoders fall behind
+  std::atomic<int> next_page(page_from);
+  std::vector<int> skipped;
+  std::exception_ptr render_error;
+  std::mutex render_error_mutex;
+
+  auto render_page = [&]() {
+    try {
+      for (int i = next_page++; i <= page_to; i = next_page++) {
+        // the pipeline drops the images after an error, Finish rethrows it
+        if (pipeline.HasError())
+          break;
+        auto page_deleter = [](PdfPage* page) { page->Release(); };
+        std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(i), page_deleter);
+        if (!page)
+          throw PdfixException();
+        int width = 0, height = 0;
+        PsImage* image = RenderPageWithBudget(page.get(), zoom, rotate, clip_rect, cancel,
+          page_timeout, width, height);
+        page.reset();
+        if (!image) {
+          std::lock_guard<std::mutex> lock(render_error_mutex);
+          skipped.push_back(i);
+          continue;
+        }
+
+        // encoding and writing continue on the pipeline threads
+        std::wstringstream ss;
+        ss << img_path << L"page" << (i + 1) << L".png";
+        pipeline.Push(image, nullptr, ss.str());
+      }
+    }
+    catch (...) {
+      std::lock_guard<std::mutex> lock(render_error_mutex);
+      if (!render_error)
+        render_error = std::current_exception();
+      // stop the other render workers
+      next_page = page_to + 1;
+    }
+  };
+
+  if (render_threads == 0)
+    render_threads = 1;
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < render_threads; i++)
+    workers.emplace_back(render_page);
+  for (auto& w : workers)
+    w.join();
+
+  pipeline.Finish();
+  if (render_error)
+    std::rethrow_exception(render_error);
+
+  doc->Close();
+
+  pdfix->Destroy();
+
+  ReportSkippedPages(skipped);
+  return skipped;
+}
+
+std::vector<int> RenderPagesMultiResolution(
+  const std::wstring& open_path,              // source PDF document
+  const std::wstring& img_path,               // output image path prefix
+  int page_from,                              // page from
+  int page_to,                                // page to
+  PdfRotate rotate,                           // page rotation
+  const std::vector<RenderPageVariant>& variants, // output sizes
+  ImageResampleFilter filter,                 // downscaling filter
+  size_t thread_count,                        // number of render threads
+  CancelToken* cancel,                        // cancel token of the whole job or nullptr
+  int page_timeout                            // time budget per page in milliseconds, 0 for none
+) {
+  // initialize Pdfix
+  if (!Pdfix_init(Pdfix_MODULE_NAME))
+    throw PdfixException();
+
+  Pdfix* pdfix = GetPdfix();
+  if (!pdfix)
+    throw std::runtime_error("GetPdfix fail");
+
+  if (variants.empty())
+    throw std::runtime_error("No output size");
+  double max_zoom = 0;
+  for (auto& variant : variants)
+    max_zoom = std::max(max_zoom, variant.zoom);
+  if (max_zoom <= 0)
+    throw std::runtime_error("Invalid zoom");
+
+  PdfDoc* doc = pdfix->OpenDoc(open_path.c_str(), L"");
+  if (!doc)
+    throw PdfixException();
+
+  auto page_count = doc->GetNumPages();
+  if (page_from > page_count || page_to > page_count)
+    throw std::runtime_error("Page number out of range");
+
+  std::atomic<int> next_page(page_from);
+  std::vector<int> skipped;
+  std::exception_ptr render_error;
+  std::mutex mutex;
+
+  auto render_page = [&]() {
+    try {
+      for (int i = next_page++; i <= page_to; i = next_page++) {
+        // rasterise once at the biggest size
+        auto page_deleter = [](PdfPage* page) { page->Release(); };
+        std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(i), page_deleter);
+        if (!page)
+          throw PdfixException();
+        int width = 0, height = 0;
+        auto image_deleter = [](PsImage* image) { image->Destroy(); };
+        std::unique_ptr<PsImage, decltype(image_deleter)> image(RenderPageWithBudget(page.get(),
+          max_zoom, rotate, PdfDevRect(), cancel, page_timeout, width, height), image_deleter);
+        page.reset();
+        if (!image) {
+          std::lock_guard<std::mutex> lock(mutex);
+          skipped.push_back(i);
+          continue;
+        }
+        ImageBuffer pixels;
+        ReadImagePixels(image.get(), width, height, pixels);
+        image.reset();
+
+        // derive and write all sizes
+        ImageBuffer resized;
+        for (auto& variant : variants) {
+          std::wstringstream ss;
+          ss << img_path << L"page" << (i + 1) << variant.suffix << L".png";
+          int variant_width = std::max(1, (int)std::lround(width * variant.zoom / max_zoom));
+          int variant_height = std::max(1, (int)std::lround(height * variant.zoom / max_zoom));
+          if (variant_width == width && variant_height == height) {
+            SaveImageBuffer(pixels, ss.str());
+            continue;
+          }
+          ResizeImageBuffer(pixels, resized, variant_width, variant_height, filter);
+          SaveImageBuffer(resized, ss.str());
+        }
+      }
+    }
+    catch (...) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!render_error)
+        render_error = std::current_exception();
+      // stop the other render workers
+      next_page = page_to + 1;
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < std::max<size_t>(thread_count, 1); i++)
+    workers.emplace_back(render_page);
+  for (auto& w : workers)
+    w.join();
+  if (render_error)
+    std::rethrow_exception(render_error);
+
+  doc->Close();
+
+  pdfix->Destroy();
+
+  ReportSkippedPages(skipped);
+  return skipped;
+}
@@ -0,0 +1,323 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// TextColumns.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/TextColumns.h"
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <memory>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <filesystem>
+#include <boost/property_tree/json_parser.hpp>
+#include "pdfixsdksamples/ExtractData.h"
+#include "pdfixsdksamples/Utils.h"
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+
+namespace TextColumns {
+
+  static const char kMagic[8] = { 'P', 'D', 'F', 'I', 'X', 'T', 'C', '1' };
+  static const size_t kTrailerSize = 7 * sizeof(uint64_t) + sizeof(kMagic);
+
+  static size_t Pad8(size_t size) { return (size + 7) & ~(size_t)7; }
+
+  Writer::Writer(
+    const std::wstring& save_path,  // output file
+    size_t row_group_size           // rows per row group
+  ) : file_(std::filesystem::path(save_path), std::ios::binary | std::ios::trunc),
+    row_group_size_(std::max<size_t>(row_group_size, 1)) {
+    if (!file_)
+      throw std::runtime_error("Text columns file open fail");
+    Write(kMagic, sizeof(kMagic));
+  }
+
+  uint32_t Writer::AddText(const std::string& text) {
+    if (text_.size() + text.size() > UINT32_MAX)
+      throw std::runtime_error("Text columns text too long");
+    auto offset = (uint32_t)text_.size();
+    text_ += text;
+    return offset;
+  }
+
+  int32_t Writer::AddRow(int page, int32_t parent, const PdfRect& bbox, uint32_t text_offset,
+    uint32_t text_length, int style, PdfElementType type) {
+    page_.push_back(page);
+    parent_.push_back(parent);
+    left_.push_back((float)bbox.left);
+    bottom_.push_back((float)bbox.bottom);
+    right_.push_back((float)bbox.right);
+    top_.push_back((float)bbox.top);
+    text_offset_.push_back(text_offset);
+    text_length_.push_back(text_length);
+    style_.push_back(style);
+    type_.push_back((uint8_t)type);
+    int32_t row = (int32_t)num_rows_++;
+    if (page_.size() >= row_group_size_)
+      FlushRowGroup();
+    return row;
+  }
+
+  void Writer::Write(const void* data, size_t size) {
+    if (size && !file_.write((const char*)data, size))
+      throw std::runtime_error("Text columns file write fail");
+    offset_ += size;
+  }
+
+  template <typename T> void Writer::WriteColumn(const std::vector<T>& column) {
+    static const char padding[8] = { 0 };
+    size_t size = column.size() * sizeof(T);
+    Write(column.data(), size);
+    Write(padding, Pad8(size) - size);
+  }
+
+  void Writer::FlushRowGroup() {
+    if (page_.empty())
+      return;
+    row_group_offsets_.push_back(offset_);
+    uint64_t num_rows = page_.size();
+    Write(&num_rows, sizeof(num_rows));
+    WriteColumn(page_);
+    WriteColumn(parent_);
+    WriteColumn(left_);
+    WriteColumn(bottom_);
+    WriteColumn(right_);
+    WriteColumn(top_);
+    WriteColumn(text_offset_);
+    WriteColumn(text_length_);
+    WriteColumn(style_);
+    WriteColumn(type_);
+    for (auto column : { &page_, &parent_, &style_ })
+      column->clear();
+    for (auto column : { &left_, &bottom_, &right_, &top_ })
+      column->clear();
+    text_offset_.clear();
+    text_length_.clear();
+    type_.clear();
+  }
+
+  void Writer::Close(const std::string& styles) {
+    FlushRowGroup();
+    uint64_t text_offset = offset_;
+    Write(text_.data(), text_.size());
+    uint64_t styles_offset = offset_;
+    Write(styles.data(), styles.size());
+    static const char padding[8] = { 0 };
+    Write(padding, Pad8(offset_) - offset_);
+
+    uint64_t row_groups_offset = offset_;
+    Write(row_group_offsets_.data(), row_group_offsets_.size() * sizeof(uint64_t));
+    uint64_t trailer[] = { num_rows_, row_group_offsets_.size(), row_groups_offset, text_offset,
+      text_.size(), styles_offset, styles.size() };
+    Write(trailer, sizeof(trailer));
+    Write(kMagic, sizeof(kMagic));
+    file_.close();
+    if (!file_)
+      throw std::runtime_error("Text columns file write fail");
+  }
+
+  Reader::Reader(const std::wstring& path) : file_(path) {
+    auto data = file_.GetData();
+    auto size = file_.GetSize();
+    if (size < sizeof(kMagic) + kTrailerSize || memcmp(data, kMagic, sizeof(kMagic)) != 0 ||
+      memcmp(data + size - sizeof(kMagic), kMagic, sizeof(kMagic)) != 0)
+      throw std::runtime_error("Not a text columns file");
+
+    uint64_t trailer[7];
+    memcpy(trailer, data + size - kTrailerSize, sizeof(trailer));
+    num_rows_ = trailer[0];
+    uint64_t num_row_groups = trailer[1];
+    uint64_t row_groups_offset = trailer[2];
+    text_offset_ = trailer[3];
+    text_size_ = trailer[4];
+    styles_offset_ = trailer[5];
+    styles_size_ = trailer[6];
+    uint64_t end = size - kTrailerSize;
+    if (row_groups_offset > end || num_row_groups > (end - row_groups_offset) / sizeof(uint64_t) ||
+      text_offset_ > end || text_size_ > end - text_offset_ ||
+      styles_offset_ > end || styles_size_ > end - styles_offset_)
+      throw std::runtime_error("Damaged text columns file");
+    row_group_offsets_.resize((size_t)num_row_groups);
+    memcpy(row_group_offsets_.data(), data + row_groups_offset,
+      row_group_offsets_.size() * sizeof(uint64_t));
+  }
+
+  RowGroup Reader::GetRowGroup(size_t index) const {
+    if (index >= row_group_offsets_.size())
+      throw std::out_of_range("Row group index out of range");
+    auto data = file_.GetData();
+    uint64_t pos = row_group_offsets_[index];
+    uint64_t end = text_offset_;
+    if (pos > end || end - pos < sizeof(uint64_t))
+      throw std::runtime_error("Damaged text columns file");
+
+    RowGroup group;
+    uint64_t num_rows;
+    memcpy(&num_rows, data + pos, sizeof(num_rows));
+    pos += sizeof(num_rows);
+    // 4 byte columns fit in the row group, the check covers the 1 byte column too
+    if (num_rows > (end - pos) / (9 * sizeof(int32_t) + 1))
+      throw std::runtime_error("Damaged text columns file");
+    group.num_rows = (size_t)num_rows;
+    auto column = [&](size_t item_size) {
+      auto ptr = data + pos;
+      pos += Pad8(item_size * group.num_rows);
+      return ptr;
+    };
+    group.page = (const int32_t*)column(sizeof(int32_t));
+    group.parent = (const int32_t*)column(sizeof(int32_t));
+    group.left = (const float*)column(sizeof(float));
+    group.bottom = (const float*)column(sizeof(float));
+    group.right = (const float*)column(sizeof(float));
+    group.top = (const float*)column(sizeof(float));
+    group.text_offset = (const uint32_t*)column(sizeof(uint32_t));
+    group.text_length = (const uint32_t*)column(sizeof(uint32_t));
+    group.style = (const int32_t*)column(sizeof(int32_t));
+    group.type = column(sizeof(uint8_t));
+    if (pos > end)
+      throw std::runtime_error("Damaged text columns file");
+    return group;
+  }
+
+  std::string Reader::GetText(uint32_t offset, uint32_t length) const {
+    if ((uint64_t)offset + length > text_size_)
+      throw std::out_of_range("Text out of range");
+    return std::string((const char*)file_.GetData() + text_offset_ + offset, length);
+  }
+
+  std::string Reader::GetStyles() const {
+    return std::string((const char*)file_.GetData() + styles_offset_, (size_t)styles_size_);
+  }
+
+  // adds rows of the text element, its lines and words
+  static void AddTextElement(Writer& writer, int page_num, PdeText* text,
+    const ExtractData::DataType& data_types, ExtractData::DocState& state) {
+    auto get_style = [&](auto* element) {
+      PdfTextState ts;
+      if (!element->GetTextState(&ts))
+        return -1;
+      return ExtractData::InternTextState(&ts, data_types, state);
+    };
+
+    // the element text is written at once, the rows point into it
+    std::string element_text;
+    std::vector<std::pair<size_t, size_t>> line_ranges, word_ranges;
+    for (int l = 0; l < text->GetNumTextLines(); l++) {
+      auto line = text->GetTextLine(l);
+      if (!line)
+        throw PdfixException();
+      if (l > 0)
+        element_text += '\n';
+      size_t line_start = element_text.size();
+      for (int w = 0; w < line->GetNumWords(); w++) {
+        auto word = line->GetWord(w);
+        if (!word)
+          throw PdfixException();
+        if (w > 0)
+          element_text += ' ';
+        size_t word_start = element_text.size();
+        element_text += ToUtf8(word->GetText());
+        word_ranges.push_back(std::make_pair(word_start, element_text.size() - word_start));
+      }
+      line_ranges.push_back(std::make_pair(line_start, element_text.size() - line_start));
+    }
+    auto base = writer.AddText(element_text);
+
+    auto text_row = writer.AddRow(page_num, -1, text->GetBBox(), base,
+      (uint32_t)element_text.size(), get_style(text), kPdeText);
+    size_t word_index = 0;
+    for (int l = 0; l < text->GetNumTextLines(); l++) {
+      auto line = text->GetTextLine(l);
+      auto line_row = writer.AddRow(page_num, text_row, line->GetBBox(),
+        base + (uint32_t)line_ranges[l].first, (uint32_t)line_ranges[l].second, get_style(line),
+        kPdeTextLine);
+      for (int w = 0; w < line->GetNumWords(); w++, word_index++) {
+        auto word = line->GetWord(w);
+        writer.AddRow(page_num, line_row, word->GetBBox(),
+          base + (uint32_t)word_ranges[word_index].first,
+          (uint32_t)word_ranges[word_index].second, get_style(word), kPdeWord);
+      }
+    }
+  }
+
+  static void AddElement(Writer& writer, int page_num, PdeElement* element,
+    const ExtractData::DataType& data_types, ExtractData::DocState& state) {
+    if (element->GetType() == kPdeText) {
+      AddTextElement(writer, page_num, (PdeText*)element, data_types, state);
+      return;
+    }
+    for (int i = 0; i < element->GetNumChildren(); i++) {
+      PdeElement* child = element->GetChild(i);
+      if (child)
+        AddElement(writer, page_num, child, data_types, state);
+    }
+  }
+
+  void Run(
+    const std::wstring& open_path,    // source PDF document
+    const std::wstring& save_path,    // output columnar file
+    const std::wstring& config_path,  // configuration file
+    size_t row_group_size,            // rows per row group
+    CancelToken* cancel               // cancel token or nullptr
+  ) {
+    // initialize Pdfix
+    if (!Pdfix_init(Pdfix_MODULE_NAME))
+      throw std::runtime_error("Pdfix initialization fail");
+
+    Pdfix* pdfix = GetPdfix();
+    if (!pdfix)
+      throw std::runtime_error("GetPdfix fail");
+
+    PdfDoc* doc = pdfix->OpenDoc(open_path.c_str(), L"");
+    if (!doc)
+      throw PdfixException();
+
+    if (!config_path.empty()) {
+      auto doc_template = doc->GetTemplate();
+      if (!doc_template)
+        throw PdfixException();
+      PsFileStream* stm = pdfix->CreateFileStream(config_path.c_str(), kPsReadOnly);
+      if (stm) {
+        if (!doc_template->LoadFromStream(stm, kDataFormatJson))
+          throw PdfixException();
+        stm->Destroy();
+      }
+    }
+
+    Writer writer(save_path, row_group_size);
+    ExtractData::DataType data_types;
+    ExtractData::DocState state;
+
+    auto page_deleter = [](PdfPage* page) { page->Release(); };
+    auto page_map_deleter = [](PdePageMap* page_map) { page_map->Release(); };
+    for (int i = 0; i < doc->GetNumPages(); i++) {
+      std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(i), page_deleter);
+      if (!page)
+        throw PdfixException();
+      std::unique_ptr<PdePageMap, decltype(page_map_deleter)> page_map(
+        page->AcquirePageMap(&CancelToken::CancelProc, cancel), page_map_deleter);
+      if (!page_map) {
+        CancelToken::ThrowIfStopped(cancel);
+        throw PdfixException();
+      }
+      auto element = page_map->GetElement();
+      if (!element)
+        throw PdfixException();
+      AddElement(writer, i, element, data_types, state);
+    }
+
+    ptree styles;
+    styles.add_child("styles", state.styles);
+    std::stringstream styles_json;
+    write_json(styles_json, styles, false);
+    writer.Close(styles_json.str());
+
+    doc->Close();
+    pdfix->Destroy();
+  }
+}
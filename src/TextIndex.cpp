@@ -0,0 +1,309 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// TextIndex.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/TextIndex.h"
+
+#include <string>
+#include <string_view>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <memory>
+#include <map>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <filesystem>
+#include "pdfixsdksamples/Utils.h"
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+namespace fs = std::filesystem;
+
+namespace TextIndex {
+
+  static const char kMagic[8] = { 'P', 'D', 'F', 'I', 'X', 'T', 'I', '1' };
+  static const size_t kTermEntrySize = 2 * sizeof(uint32_t) + sizeof(uint64_t);
+  static const size_t kTrailerSize = 4 * sizeof(uint64_t) + sizeof(kMagic);
+
+  // letters and digits, the C locale of the wide character functions knows ASCII only, so
+  // characters above Latin-1 punctuation count as letters except the Unicode punctuation blocks
+  static bool IsTokenChar(wchar_t ch) {
+    if (ch < 0x80)
+      return (ch >= L'0' && ch <= L'9') || (ch >= L'a' && ch <= L'z') || (ch >= L'A' && ch <= L'Z');
+    if (ch < 0xc0 || ch == 0xd7 || ch == 0xf7)
+      return false;
+    if ((ch >= 0x2000 && ch <= 0x206f) || (ch >= 0x3000 && ch <= 0x303f) ||
+      (ch >= 0xff00 && ch <= 0xff0f))
+      return false;
+    return true;
+  }
+
+  static wchar_t ToLower(wchar_t ch) {
+    if ((ch >= L'A' && ch <= L'Z') || (ch >= 0xc0 && ch <= 0xde && ch != 0xd7))
+      return ch + 0x20;
+    return ch;
+  }
+
+  std::vector<std::string> Tokenize(const std::wstring& text) {
+    std::vector<std::string> tokens;
+    std::wstring token;
+    for (auto ch : text) {
+      if (IsTokenChar(ch)) {
+        token += ToLower(ch);
+        continue;
+      }
+      if (!token.empty())
+        tokens.push_back(ToUtf8(token));
+      token.clear();
+    }
+    if (!token.empty())
+      tokens.push_back(ToUtf8(token));
+    return tokens;
+  }
+
+  static void PutVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+      out += (char)(value | 0x80);
+      value >>= 7;
+    }
+    out += (char)value;
+  }
+
+  // returns false at the end of the data or on a too long number
+  static bool GetVarint(const uint8_t*& data, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && data < end; shift += 7) {
+      uint8_t byte = *data++;
+      value |= (uint64_t)(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        return true;
+    }
+    return false;
+  }
+
+  // adds the tokens of the page map words in reading order
+  static void AddElement(PdeElement* element, int page_num, uint32_t& position,
+    std::map<std::string, std::vector<Hit>>& postings) {
+    if (element->GetType() == kPdeText) {
+      auto text = (PdeText*)element;
+      for (int l = 0; l < text->GetNumTextLines(); l++) {
+        auto line = text->GetTextLine(l);
+        if (!line)
+          throw PdfixException();
+        for (int w = 0; w < line->GetNumWords(); w++) {
+          auto word = line->GetWord(w);
+          if (!word)
+            throw PdfixException();
+          for (auto& token : Tokenize(word->GetText()))
+            postings[token].push_back({ page_num, position++ });
+        }
+      }
+      return;
+    }
+    for (int i = 0; i < element->GetNumChildren(); i++) {
+      auto child = element->GetChild(i);
+      if (child)
+        AddElement(child, page_num, position, postings);
+    }
+  }
+
+  void Build(
+    PdfDoc* doc,                      // indexed document
+    uint64_t pdf_hash,                // hash of the PDF file, tells if the index is current
+    const std::wstring& index_path,   // output index file
+    CancelToken* cancel               // cancel token or nullptr
+  ) {
+    std::map<std::string, std::vector<Hit>> postings;
+    auto page_deleter = [](PdfPage* page) { page->Release(); };
+    auto page_map_deleter = [](PdePageMap* page_map) { page_map->Release(); };
+    for (int i = 0; i < doc->GetNumPages(); i++) {
+      std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(i), page_deleter);
+      if (!page)
+        throw PdfixException();
+      std::unique_ptr<PdePageMap, decltype(page_map_deleter)> page_map(
+        page->AcquirePageMap(&CancelToken::CancelProc, cancel), page_map_deleter);
+      if (!page_map) {
+        CancelToken::ThrowIfStopped(cancel);
+        throw PdfixException();
+      }
+      auto element = page_map->GetElement();
+      if (!element)
+        throw PdfixException();
+      uint32_t position = 0;
+      AddElement(element, i, position, postings);
+    }
+
+    // the postings follow the magic, the terms and the sorted table follow the postings
+    std::string data(kMagic, sizeof(kMagic));
+    std::vector<uint64_t> postings_offsets;
+    for (auto& term : postings) {
+      postings_offsets.push_back(data.size());
+      PutVarint(data, term.second.size());
+      Hit prev = { 0, 0 };
+      for (auto& hit : term.second) {
+        PutVarint(data, hit.page_num - prev.page_num);
+        PutVarint(data, hit.page_num == prev.page_num ? hit.position - prev.position : hit.position);
+        prev = hit;
+      }
+    }
+    uint64_t terms_offset = data.size();
+    for (auto& term : postings)
+      data += term.first;
+    data.append((8 - data.size() % 8) % 8, '\0');
+
+    uint64_t terms_table_offset = data.size();
+    uint32_t term_offset = 0;
+    size_t index = 0;
+    for (auto& term : postings) {
+      uint32_t entry[] = { term_offset, (uint32_t)term.first.size() };
+      data.append((const char*)entry, sizeof(entry));
+      data.append((const char*)&postings_offsets[index++], sizeof(uint64_t));
+      term_offset += (uint32_t)term.first.size();
+    }
+    uint64_t trailer[] = { postings.size(), terms_table_offset, terms_offset, pdf_hash };
+    data.append((const char*)trailer, sizeof(trailer));
+    data.append(kMagic, sizeof(kMagic));
+
+    // write to a temporary file first, readers never see a partial index
+    fs::path path(index_path);
+    std::stringstream tmp_name;
+    tmp_name << path.filename().string() << "." << std::this_thread::get_id() << ".tmp";
+    auto tmp_path = path.parent_path() / tmp_name.str();
+    {
+      std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+      file.write(data.data(), data.size());
+      if (!file)
+        throw std::runtime_error("Text index write fail");
+    }
+    fs::rename(tmp_path, path);
+  }
+
+  Reader::Reader(const std::wstring& index_path) : file_(index_path) {
+    auto data = file_.GetData();
+    auto size = file_.GetSize();
+    if (size < sizeof(kMagic) + kTrailerSize || memcmp(data, kMagic, sizeof(kMagic)) != 0 ||
+      memcmp(data + size - sizeof(kMagic), kMagic, sizeof(kMagic)) != 0)
+      throw std::runtime_error("Not a text index file");
+
+    uint64_t trailer[4];
+    memcpy(trailer, data + size - kTrailerSize, sizeof(trailer));
+    num_terms_ = trailer[0];
+    terms_table_offset_ = trailer[1];
+    terms_offset_ = trailer[2];
+    pdf_hash_ = trailer[3];
+    uint64_t end = size - kTrailerSize;
+    if (terms_offset_ > terms_table_offset_ || terms_table_offset_ > end ||
+      num_terms_ > (end - terms_table_offset_) / kTermEntrySize)
+      throw std::runtime_error("Damaged text index file");
+  }
+
+  std::vector<Hit> Reader::FindTerm(const std::string& term) const {
+    auto data = file_.GetData();
+    auto get_entry = [&](uint64_t index, uint32_t& term_offset, uint32_t& term_length,
+      uint64_t& postings_offset) {
+      auto entry = data + terms_table_offset_ + index * kTermEntrySize;
+      memcpy(&term_offset, entry, sizeof(term_offset));
+      memcpy(&term_length, entry + 4, sizeof(term_length));
+      memcpy(&postings_offset, entry + 8, sizeof(postings_offset));
+      if ((uint64_t)term_offset + term_length > terms_table_offset_ - terms_offset_ ||
+        postings_offset > terms_offset_)
+        throw std::runtime_error("Damaged text index file");
+      return std::string_view((const char*)data + terms_offset_ + term_offset, term_length);
+    };
+
+    uint64_t lo = 0, hi = num_terms_;
+    uint32_t term_offset, term_length;
+    uint64_t postings_offset = 0;
+    while (lo < hi) {
+      uint64_t mid = lo + (hi - lo) / 2;
+      if (get_entry(mid, term_offset, term_length, postings_offset) < term)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    std::vector<Hit> hits;
+    if (lo == num_terms_ || get_entry(lo, term_offset, term_length, postings_offset) != term)
+      return hits;
+
+    const uint8_t* ptr = data + postings_offset;
+    const uint8_t* end = data + terms_offset_;
+    uint64_t count, page_delta, position;
+    if (!GetVarint(ptr, end, count) || count > (uint64_t)(end - ptr))
+      throw std::runtime_error("Damaged text index file");
+    hits.reserve((size_t)count);
+    Hit hit = { 0, 0 };
+    for (uint64_t i = 0; i < count; i++) {
+      if (!GetVarint(ptr, end, page_delta) || !GetVarint(ptr, end, position))
+        throw std::runtime_error("Damaged text index file");
+      hit.position = (uint32_t)(page_delta ? position : hit.position + position);
+      hit.page_num += (int)page_delta;
+      hits.push_back(hit);
+    }
+    return hits;
+  }
+
+  std::vector<Hit> Reader::Find(const std::wstring& query) const {
+    auto tokens = Tokenize(query);
+    if (tokens.empty())
+      return std::vector<Hit>();
+
+    // hits are sorted by page and position, a phrase keeps the starts followed by the next tokens
+    auto less = [](const Hit& a, const Hit& b) {
+      return a.page_num < b.page_num || (a.page_num == b.page_num && a.position < b.position);
+    };
+    auto hits = FindTerm(tokens[0]);
+    for (size_t k = 1; k < tokens.size() && !hits.empty(); k++) {
+      auto next = FindTerm(tokens[k]);
+      hits.erase(std::remove_if(hits.begin(), hits.end(), [&](const Hit& hit) {
+        Hit follower = { hit.page_num, hit.position + (uint32_t)k };
+        return !std::binary_search(next.begin(), next.end(), follower, less);
+      }), hits.end());
+    }
+    return hits;
+  }
+
+  void Run(
+    const std::wstring& open_path,    // source PDF document
+    const std::wstring& query,        // searched word or phrase
+    CancelToken* cancel               // cancel token or nullptr
+  ) {
+    // initialize Pdfix
+    if (!Pdfix_init(Pdfix_MODULE_NAME))
+      throw std::runtime_error("Pdfix initialization fail");
+
+    Pdfix* pdfix = GetPdfix();
+    if (!pdfix)
+      throw std::runtime_error("GetPdfix fail");
+
+    auto index_path = open_path + L".idx";
+    auto pdf_hash = HashFile(open_path);
+    bool current = false;
+    try {
+      current = Reader(index_path).GetPdfHash() == pdf_hash;
+    }
+    catch (std::exception&) {
+      // missing or damaged index is built again
+    }
+
+    if (!current) {
+      PdfDoc* doc = pdfix->OpenDoc(open_path.c_str(), L"");
+      if (!doc)
+        throw PdfixException();
+      Build(doc, pdf_hash, index_path, cancel);
+      doc->Close();
+    }
+
+    Reader reader(index_path);
+    auto hits = reader.Find(query);
+    std::cout << hits.size() << " hits of \"" << ToUtf8(query) << "\" in " << reader.GetNumTerms()
+      << " terms" << std::endl;
+    for (auto& hit : hits)
+      std::cout << "  page " << hit.page_num + 1 << ", word " << hit.position << std::endl;
+
+    pdfix->Destroy();
+  }
+}
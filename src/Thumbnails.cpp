@@ -0,0 +1,273 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Thumbnails.cpp
+// Copyright (c) 2020 Pdfix. All Rights Reserved.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "pdfixsdksamples/Thumbnails.h"
+
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <exception>
+#include "pdfixsdksamples/Utils.h"
+#include "Pdfix.h"
+
+using namespace PDFixSDK;
+namespace fs = std::filesystem;
+
+namespace Thumbnails {
+
+  // cache file name, built from everything the thumbnail depends on
+  static std::string GetCacheKey(const std::string& doc_hash, int page_num,
+    const ThumbnailParams& params) {
+    std::stringstream ss;
+    ss << doc_hash << "_p" << page_num << "_" << params.width << "x" << params.height
+      << "_r" << (int)params.rotate << "_f" << params.render_flags;
+    switch (params.img_params.format) {
+      case kImageFormatPng: ss << ".png"; break;
+      case kImageFormatJpg: ss << "_q" << params.img_params.quality << ".jpg"; break;
+      default: ss << "_t" << (int)params.img_params.format << ".img";
+    }
+    return ss.str();
+  }
+
+  ThumbnailCache::ThumbnailCache(
+    const std::wstring& cache_dir,          // directory holding the cached thumbnails
+    uint64_t max_bytes                      // max total size of the cached files
+  ) : dir_(cache_dir), max_bytes_(max_bytes) {
+    fs::create_directories(dir_);
+
+    // restore the LRU order from the file modification times
+    std::vector<std::pair<fs::file_time_type, Entry>> files;
+    for (auto& item : fs::directory_iterator(dir_)) {
+      if (!item.is_regular_file() || item.path().extension() == ".tmp")
+        continue;
+      Entry entry = { item.path().filename().string(), (uint64_t)item.file_size() };
+      files.push_back(std::make_pair(item.last_write_time(), entry));
+    }
+    std::sort(files.begin(), files.end(), [](auto& a, auto& b) { return a.first > b.first; });
+    for (auto& file : files) {
+      lru_.push_back(file.second);
+      index_[file.second.name] = std::prev(lru_.end());
+      total_bytes_ += file.second.size;
+    }
+    Trim();
+  }
+
+  std::vector<uint8_t> ThumbnailCache::Get(PdfDoc* doc, const std::string& doc_hash, int page_num,
+    const ThumbnailParams& params, CancelToken* cancel) {
+    auto name = GetCacheKey(doc_hash, page_num, params);
+
+    std::vector<uint8_t> data;
+    if (Load(name, data))
+      return data;
+
+    auto page_deleter = [](PdfPage* page) { page->Release(); };
+    std::unique_ptr<PdfPage, decltype(page_deleter)> page(doc->AcquirePage(page_num), page_deleter);
+    if (!page)
+      throw PdfixException();
+    data = RenderThumbnail(page.get(), params, cancel);
+    Store(name, data);
+    return data;
+  }
+
+  bool ThumbnailCache::Load(const std::string& name, std::vector<uint8_t>& data) {
+    // look up the entry under the lock, read the file outside of it so that concurrent hits do
+    // not wait for each other's disk I/O
+    auto path = dir_ / name;
+    uint64_t size = 0;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = index_.find(name);
+      if (it == index_.end()) {
+        misses_++;
+        return false;
+      }
+      size = it->second->size;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    bool loaded = false;
+    if (file) {
+      data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+      loaded = data.size() == size;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(name);
+    if (loaded) {
+      // move to the front and persist the access time for the next run, the entry may have been
+      // evicted in the meantime
+      if (it != index_.end())
+        lru_.splice(lru_.begin(), lru_, it->second);
+      std::error_code ec;
+      fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+      hits_++;
+      return true;
+    }
+    // the file was removed or damaged outside of the cache
+    if (it != index_.end() && it->second->size == size) {
+      total_bytes_ -= it->second->size;
+      lru_.erase(it->second);
+      index_.erase(it);
+    }
+    misses_++;
+    return false;
+  }
+
+  void ThumbnailCache::Store(const std::string& name, const std::vector<uint8_t>& data) {
+    // write to a temporary file first, readers never see a partial thumbnail
+    auto path = dir_ / name;
+    std::stringstream tmp_name;
+    tmp_name << name << "." << std::this_thread::get_id() << ".tmp";
+    auto tmp_path = dir_ / tmp_name.str();
+    {
+      std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+      file.write((const char*)data.data(), data.size());
+      if (!file)
+        throw std::runtime_error("Thumbnail cache write fail");
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    fs::rename(tmp_path, path);
+    auto it = index_.find(name);
+    if (it != index_.end()) {
+      total_bytes_ -= it->second->size;
+      lru_.erase(it->second);
+    }
+    lru_.push_front({ name, (uint64_t)data.size() });
+    index_[name] = lru_.begin();
+    total_bytes_ += data.size();
+    Trim();
+  }
+
+  // evict least recently used thumbnails, called with the mutex locked
+  void ThumbnailCache::Trim() {
+    while (total_bytes_ > max_bytes_ && !lru_.empty()) {
+      auto& entry = lru_.back();
+      std::error_code ec;
+      fs::remove(dir_ / entry.name, ec);
+      total_bytes_ -= entry.size;
+      index_.erase(entry.name);
+      lru_.pop_back();
+    }
+  }
+
+  std::vector<uint8_t> RenderThumbnail(PdfPage* page, const ThumbnailParams& params,
+    CancelToken* cancel) {
+    auto page_view_deleter = [](PdfPageView* page_view) { page_view->Release(); };
+
+    // fit the rotated page into the target box
+    double zoom = 1;
+    {
+      std::unique_ptr<PdfPageView, decltype(page_view_deleter)> page_view(
+        page->AcquirePageView(1, params.rotate), page_view_deleter);
+      if (!page_view)
+        throw PdfixException();
+      int width = std::max(1, page_view->GetDeviceWidth());
+      int height = std::max(1, page_view->GetDeviceHeight());
+      zoom = std::min((double)params.width / width, (double)params.height / height);
+    }
+
+    std::unique_ptr<PdfPageView, decltype(page_view_deleter)> page_view(
+      page->AcquirePageView(zoom, params.rotate), page_view_deleter);
+    if (!page_view)
+      throw PdfixException();
+
+    auto image_deleter = [](PsImage* image) { image->Destroy(); };
+    std::unique_ptr<PsImage, decltype(image_deleter)> image(GetPdfix()->CreateImage(
+      std::max(1, page_view->GetDeviceWidth()), std::max(1, page_view->GetDeviceHeight()),
+      kImageDIBFormatArgb), image_deleter);
+    if (!image)
+      throw PdfixException();
+
+    PdfPageRenderParams render_params;
+    render_params.image = image.get();
+    page_view->GetDeviceMatrix(&render_params.matrix);
+    render_params.render_flags = params.render_flags;
+    if (!page->DrawContent(&render_params, &CancelToken::CancelProc, cancel)) {
+      CancelToken::ThrowIfStopped(cancel);
+      throw PdfixException();
+    }
+
+    auto stm_deleter = [](PsStream* stm) { stm->Destroy(); };
+    std::unique_ptr<PsStream, decltype(stm_deleter)> stm(GetPdfix()->CreateMemStream(), stm_deleter);
+    if (!stm)
+      throw PdfixException();
+    PdfImageParams img_params = params.img_params;
+    if (!image->SaveToStream(stm.get(), &img_params))
+      throw PdfixException();
+
+    std::vector<uint8_t> data(stm->GetSize());
+    if (!data.empty() && !stm->Read(0, data.data(), (int)data.size()))
+      throw PdfixException();
+    return data;
+  }
+
+  void GenerateThumbnails(PdfDoc* doc, const std::string& doc_hash, ThumbnailCache& cache,
+    const ThumbnailParams& params, size_t thread_count, CancelToken* cancel) {
+    int num_pages = doc->GetNumPages();
+    std::atomic<int> next_page(0);
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    auto worker = [&]() {
+      try {
+        for (int i = next_page++; i < num_pages; i = next_page++) {
+          // cached pages are not rendered, the token is checked for them too
+          CancelToken::ThrowIfStopped(cancel);
+          cache.Get(doc, doc_hash, i, params, cancel);
+        }
+      }
+      catch (...) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!error)
+          error = std::current_exception();
+        next_page = num_pages;
+      }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < std::max<size_t>(thread_count, 1); i++)
+      workers.emplace_back(worker);
+    for (auto& w : workers)
+      w.join();
+    if (error)
+      std::rethrow_exception(error);
+  }
+
+  void Run(
+    const std::wstring& open_path,          // source PDF document
+    const std::wstring& cache_dir,          // thumbnail cache directory
+    uint64_t max_cache_bytes,               // max total size of the cache
+    const ThumbnailParams& params,          // thumbnail parameters
+    size_t thread_count,                    // max number of threads
+    CancelToken* cancel                     // cancel token or nullptr
+  ) {
+    // initialize Pdfix
+    if (!Pdfix_init(Pdfix_MODULE_NAME))
+      throw std::runtime_error("Pdfix initialization fail");
+
+    Pdfix* pdfix = GetPdfix();
+    if (!pdfix)
+      throw std::runtime_error("GetPdfix fail");
+
+    PdfDoc* doc = pdfix->OpenDoc(open_path.c_str(), L"");
+    if (!doc)
+      throw PdfixException();
+
+    ThumbnailCache cache(cache_dir, max_cache_bytes);
+    GenerateThumbnails(doc, HashToHex(HashFile(open_path)), cache, params, thread_count, cancel);
+
+    std::cout << "Thumbnails: " << cache.GetHits() << " cached, " << cache.GetMisses()
+      << " rendered" << std::endl;
+
+    doc->Close();
+    pdfix->Destroy();
+  }
+}
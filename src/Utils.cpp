@@ -9,6 +9,8 @@
 #include <locale.h>
 #include <codecvt>
 #include <math.h>
+#include <vector>
+#include <algorithm>
 #ifdef _WIN32
 #include <Windows.h>
 extern HINSTANCE ghInstance;
@@ -133,6 +135,67 @@ std::string PsStreamEncodeBase64(PsStream* stream) {
   return Base64Encode((unsigned char*)&buffer[0], len);
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Hashing utils
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// 64-bit FNV-1a, pass the previous result as hash to continue hashing
+uint64_t Fnv1aHash(const void* data, size_t size, uint64_t hash) {
+  auto bytes = (const unsigned char*)data;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+// CRC-32 of gzip and PNG, pass the previous result as crc to continue
+uint32_t Crc32(const void* data, size_t size, uint32_t crc) {
+  static const std::vector<uint32_t> table = []() {
+    std::vector<uint32_t> t(256);
+    for (uint32_t n = 0; n < 256; n++) {
+      uint32_t c = n;
+      for (int k = 0; k < 8; k++)
+        c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+      t[n] = c;
+    }
+    return t;
+  }();
+  auto bytes = (const unsigned char*)data;
+  crc = ~crc;
+  for (size_t i = 0; i < size; i++)
+    crc = table[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+  return ~crc;
+}
+
+// hash of the file content
+uint64_t HashFile(const std::wstring& path) {
+  PsStream* stm = GetPdfix()->CreateFileStream(path.c_str(), kPsReadOnly);
+  if (!stm)
+    throw PdfixException();
+
+  uint64_t hash = Fnv1aHash(nullptr, 0);
+  std::vector<unsigned char> buffer(65536);
+  int size = stm->GetSize();
+  for (int pos = 0; pos < size; pos += (int)buffer.size()) {
+    int read = std::min(size - pos, (int)buffer.size());
+    if (!stm->Read(pos, &buffer[0], read)) {
+      stm->Destroy();
+      throw PdfixException();
+    }
+    hash = Fnv1aHash(&buffer[0], read, hash);
+  }
+  stm->Destroy();
+  return hash;
+}
+
+std::string HashToHex(uint64_t hash) {
+  static const char digits[] = "0123456789abcdef";
+  std::string result(16, '0');
+  for (int i = 15; i >= 0; i--, hash >>= 4)
+    result[i] = digits[hash & 0xf];
+  return result;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // PdfMatrix utils
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -188,3 +251,17 @@ void PdfMatrixTranslate(PdfMatrix& m, double x, double y, bool prepend) {
   m.e += x;
   m.f += y; 
 }
+
+// returns false when the matrix is not invertible
+bool PdfMatrixInverse(const PdfMatrix& m, PdfMatrix& inverse) {
+  double det = m.a * m.d - m.b * m.c;
+  if (fabs(det) < 1e-12)
+    return false;
+  inverse.a = m.d / det;
+  inverse.b = -m.b / det;
+  inverse.c = -m.c / det;
+  inverse.d = m.a / det;
+  inverse.e = (m.c * m.f - m.d * m.e) / det;
+  inverse.f = (m.b * m.e - m.a * m.f) / det;
+  return true;
+}